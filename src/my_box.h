@@ -21,8 +21,9 @@ struct d_min_struct
 struct face_struct
 {
 	float normal[3];
-	int i_vertices[4]; //indices of the vertices that make up the face.
-	int num_verts;	//could be 3 or 4
+	int * i_vertices; //indices of the vertices that make up the face, points into the hull's face_vertices.
+	int num_verts;	//any number >= 3, counter clockwise seen from outside
+	int i_half_edge;	//half edge from i_vertices[0] to i_vertices[1]
 };
 
 struct edge_struct
@@ -32,14 +33,68 @@ struct edge_struct
 	int i_face[2];  //adjacent faces index
 };
 
+/*
+Half edge of a hull, made by InitHullHalfEdges(). Edge e of the hull is half edges 2e
+(i_vertices[0] -> i_vertices[1]) and 2e+1 (the other way), so the twin of h is h^1 and
+its edge is h/2.
+*/
+struct half_edge_struct
+{
+	int i_vertex;	//vertex the half edge starts at
+	int i_twin;
+	int i_next;		//next half edge counter clockwise around i_face
+	int i_face;
+};
+
+//Gauss map arc of an edge: the great arc between the normals of its two faces
+struct gauss_arc_struct
+{
+	float a[3];		//normal of face i_face[0]
+	float b[3];		//normal of face i_face[1]
+	float bxa[3];	//b x a, normal of the arc's plane. the edge direction if a == -b
+	int is_antipodal;	//1 if the faces point in opposite directions (flat hulls)
+};
+
+//faces or edges of a hull that are parallel, up to sign. made by InitHullAxisGroups()
+struct axis_group_struct
+{
+	int i_rep;			//face or edge whose normal is the axis of the group
+	int i_first;		//first member in the hull's group member array
+	int num_members;
+};
+
 struct box_collision_struct
 {
 	float * positions;	//array of vec3's (use array from no_tex_model_struct)
 	struct face_struct * faces;
 	struct edge_struct * edges;
+	int * face_vertices;	//vertex indices of all faces, one block
+	int num_face_vertices;
 	int num_pos;	//# of pos vertices
 	int num_faces;
 	int num_edges;
+	float * soa;	//copy of positions laid out x[num_soa], y[num_soa], z[num_soa] for the simd support kernels
+	int num_soa;	//num_pos rounded up to SAT_SIMD_WIDTH
+	int is_box;		//1 if the hull is an axis aligned box centered on the body's pos, see InitHullBoxExtents()
+	float half_extents[3];	//box only. along the local x, y, z axes
+	int box_face[3][2];	//box only. face whose outward normal is +axis k ([k][0]) or -axis k ([k][1])
+	struct axis_group_struct * face_groups;	//unique face axes
+	int * face_group;			//group of each face
+	int num_face_groups;
+	struct axis_group_struct * edge_groups;	//unique edge directions
+	int * edge_group_members;	//edge indices sorted by group
+	int num_edge_groups;
+	struct gauss_arc_struct * arcs;	//one per edge
+	int * adj_first;	//neighbors of vertex i are adj[adj_first[i]] .. adj[adj_first[i+1]-1]
+	int * adj;
+	struct half_edge_struct * half_edges;	//2 per edge
+	int num_half_edges;
+	int * vertex_half_edge;	//a half edge that starts at each vertex
+	int max_face_verts;		//vertices of the largest face
+	float * clip_scratch;	//clip lists of CreateFaceContact() when the largest face has more than SAT_CLIP_STACK_VERTS vertices, 10*max_face_verts floats
+	int * clip_id_scratch;	//3*max_face_verts ints, with clip_scratch
+	int use_hill_climb;	//1 = support queries walk adj instead of scanning every vertex. set for hulls with >= SAT_HILL_CLIMB_MIN_VERTS
+	int is_local;	//1 if the positions and normals are in the body's frame, like the shapes of a shape_registry_struct
 };
 
 struct box_struct
@@ -55,7 +110,18 @@ struct box_struct
 	float newLinearVel[3];
 	float newAngularMomentum[3];
 	float newAngularVelQ[4];
-	struct box_collision_struct hull;
+	float splitLinearVel[3];	//pseudo velocities of the split impulse. they only move the box in UpdateBoxSimulation(), which zeroes them
+	float splitAngularVel[3];
+	struct box_collision_struct * hull;	//the shared shape hull or a world space copy of it, see SetBodyShape()
+	int shape;	//handle of the body's shape in its shape_registry_struct
+};
+
+//features of the two hulls that made a contact. a contact with the same id on the
+//next step is the same contact.
+struct contact_id_struct
+{
+	int feature;	//SAT_FEATURE_FACE_A, SAT_FEATURE_FACE_B or SAT_FEATURE_EDGES
+	int index[3];	//face: reference face, incident vertex, reference half edge that clipped it or -1. edges: edge of A, edge of B, -1
 };
 
 struct contact_info_struct
@@ -63,6 +129,10 @@ struct contact_info_struct
 	float point[3];		//world-space contact point
 	float normal[3];	//from object B to A
 	float penetration;	//negative for separated objects
+	float local_point[2][3];	//the contact on boxA and on boxB, in the frame of each box
+	struct contact_id_struct id;
+	int age;	//number of steps the contact was carried forward
+	float normal_impulse;	//impulse accumulated along the normal, the next step starts from it
 };
 
 struct contact_manifold_struct
@@ -70,7 +140,7 @@ struct contact_manifold_struct
 	struct contact_info_struct contacts[4];
 	struct box_struct * overlappedBoxes[2]; //the two boxes in contact, [0] = boxA, [1] = boxB
 	int num_contacts;
-
+	int is_complete;	//1 if every vertex of the incident face made a contact, so refreshing the contacts can't miss a new one
 };
 
 #endif 
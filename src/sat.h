@@ -0,0 +1,480 @@
+#ifndef SAT_H
+#define SAT_H
+
+/*
+libsat: separating axis theorem collision detection and impulse solver for
+convex hulls. Has no dependency on X11 or OpenGL.
+*/
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "my_box.h"
+
+/*Broadphase structs*/
+struct aabb_struct
+{
+	float min[3];
+	float max[3];
+};
+
+struct broadphase_pair_struct
+{
+	int i_body[2];	//indices into the body array given to the broadphase. i_body[0] < i_body[1]
+};
+
+struct sap_endpoint_struct
+{
+	float value;	//min or max of the body's aabb along x
+	int i_body;
+	int is_max;		//0 = min endpoint, 1 = max endpoint
+};
+
+//sweep-and-prune broadphase. Endpoints are kept sorted along x between steps so
+//re-sorting them is close to linear when bodies move a little each step.
+struct sap_struct
+{
+	struct sap_endpoint_struct * endpoints;	//2 per body
+	struct aabb_struct * aabbs;				//world aabb of each body
+	int * active;		//bodies whose x interval is open during the sweep
+	int num_bodies;
+	int max_bodies;
+	struct broadphase_pair_struct * pairs;	//output of SapUpdate()
+	int num_pairs;
+	int max_pairs;
+};
+
+/*Broadphase types*/
+#define BROADPHASE_SAP 0
+#define BROADPHASE_BVH 1
+#define BROADPHASE_GRID 2
+
+#define BVH_NULL_NODE -1
+
+struct bvh_node_struct
+{
+	struct aabb_struct aabb;	//for leaves this is the fat aabb
+	int parent;
+	int child[2];	//BVH_NULL_NODE for leaves
+	int next;		//next node in the free list
+	int height;		//0 for leaves, -1 for free nodes
+	int i_body;		//leaves only. index into the body array
+};
+
+//dynamic aabb tree broadphase. Leaves hold aabbs enlarged by 'margin' so a body
+//only has to be re-inserted once it moves outside of its fat aabb.
+struct bvh_struct
+{
+	struct bvh_node_struct * nodes;
+	int root;
+	int num_nodes;
+	int max_nodes;
+	int free_list;
+	float margin;
+	int * proxies;					//leaf node of each body
+	struct aabb_struct * aabbs;		//tight world aabb of each body
+	int num_bodies;
+	int max_bodies;
+	int * stack;					//traversal stack
+	int max_stack;
+	int num_reinserted;				//# of bodies re-inserted by the last BvhUpdate()
+	struct broadphase_pair_struct * pairs;	//output of BvhUpdate()
+	int num_pairs;
+	int max_pairs;
+};
+
+//fixed set of worker threads for parallel-for style jobs
+struct thread_pool_struct
+{
+	pthread_t * workers;
+	int num_workers;		//num_threads-1. the calling thread does work too
+	int num_threads;
+	pthread_mutex_t lock;
+	pthread_cond_t work_cond;
+	pthread_cond_t done_cond;
+	void (*job)(void * user, int i_task);
+	void * job_user;
+	int num_tasks;
+	atomic_int next_task;	//next task to hand out
+	int num_workers_done;
+	int generation;			//incremented by each ThreadPoolRun()
+	int shutdown;
+};
+
+//bodies that touch more cells than this skip the grid and are tested against every body
+#define GRID_MAX_CELLS_PER_BODY 64
+
+struct grid_entry_struct
+{
+	unsigned int hash;	//hash of the cell coordinates
+	int i_body;
+};
+
+struct pair_list_struct
+{
+	struct broadphase_pair_struct * pairs;
+	int num_pairs;
+	int max_pairs;
+	int is_failed;
+};
+
+//uniform spatial hash grid broadphase. Rebuilt every step, each stage is split
+//into tasks that run on the thread pool.
+struct grid_struct
+{
+	float cell_size;
+	struct thread_pool_struct * pool;	//0 = single threaded
+	struct box_struct ** bodies;		//bodies of the current GridUpdate()
+	int num_bodies;
+	int max_bodies;
+	struct aabb_struct * aabbs;			//world aabb of each body
+	int * cell_counts;					//# of cells touched by each body, -1 for large bodies
+	int * cell_offsets;					//first entry of each body
+	int * large_bodies;
+	int num_large;
+	struct grid_entry_struct * entries;	//sorted by (hash, i_body)
+	struct grid_entry_struct * temp_entries;
+	int num_entries;
+	int max_entries;
+	int merge_width;					//# of sorted chunks per run in the current merge pass
+	int num_tasks;
+	int * task_ranges;					//entry range of each pair task, num_tasks+1
+	struct pair_list_struct * task_pairs;	//pairs found by each task
+	struct broadphase_pair_struct * pairs;	//output of GridUpdate()
+	int num_pairs;
+	int max_pairs;
+};
+
+/*Cached separating axis features*/
+#define SAT_FEATURE_NONE 0
+#define SAT_FEATURE_FACE_A 1	//index[0] = face of hull A
+#define SAT_FEATURE_FACE_B 2	//index[0] = face of hull B
+#define SAT_FEATURE_EDGES 3		//index[0] = edge of hull A, index[1] = edge of hull B
+
+//feature that gave the last separating axis, or the min penetration, of a pair.
+//it is tested first on the next step.
+struct sat_cache_struct
+{
+	int feature;	//SAT_FEATURE_*
+	int index[2];
+	int is_separated;	//1 if the feature separated the hulls last time
+	int support[2];	//support vertices of A and B along the feature's axis, hill climbing starts there
+};
+
+//state that is kept between steps for a pair of bodies
+struct pair_cache_entry_struct
+{
+	struct box_struct * body[2];	//0 for empty slots
+	unsigned int last_step;			//last step PairCacheGet() returned this entry. stale if it's older than the last step
+	struct sat_cache_struct sat;
+	struct contact_manifold_struct manifold;	//contacts of the last step, see ManifoldRefresh()
+};
+
+//open addressing hash table keyed by the body pair
+struct pair_cache_struct
+{
+	struct pair_cache_entry_struct * entries;
+	int num_entries;	//used slots, live or stale
+	int max_entries;	//power of 2
+	unsigned int step;
+};
+
+//hulls with more face directions than this use the full separating axis search
+#define SAT_MAX_AXIS_GROUPS 64
+#define SAT_ARC_BLOCK 64	//edges of B tested per Minkowski face batch
+#define SAT_CLIP_STACK_VERTS 16	//incident faces up to this size are clipped in stack buffers
+//a kept contact is made again once its points on the two bodies drift this far apart along the contact plane
+#define SAT_CONTACT_DRIFT 0.01f
+//hulls with fewer vertices than this scan every vertex with the simd kernels for support queries
+#define SAT_HILL_CLIMB_MIN_VERTS 32
+
+//global switches of the narrowphase
+struct sat_config_struct
+{
+	int early_out;	//1 = FindSeparatingAxis() returns as soon as an axis separates the hulls
+	int box_path;	//1 = pairs of box hulls use FindSeparatingAxisBox(). on by default
+	int unique_axes;	//1 = test each face and edge direction of a hull once. on by default
+	int persistent_contacts;	//1 = reuse the contacts kept in the pair cache while their features don't change. on by default
+};
+
+extern struct sat_config_struct g_sat_config;
+
+//switches of the contact solver
+struct solver_config_struct
+{
+	int num_iterations;	//max velocity iterations over the contacts of a manifold each time it is solved
+	int num_sweeps;		//max passes of the global solver over all manifolds, each solves every manifold once
+	int warm_start;		//1 = apply the impulses of the last step before iterating
+	float residual_tolerance;	//stop once no impulse of an iteration (a sweep for the global solver) changes more than this. 0 = always run them all
+	int global_solver;	//1 = solve the contacts of all pairs together with a contact_solver_struct. on by default, 0 = pairs are solved one by one
+	int graph_coloring;	//1 = the global solver goes through batches of manifolds that share no body, in parallel. on by default
+	float bias_factor;	//fraction of the penetration pushed out per step by the Baumgarte bias of the global solver
+	float pair_bias_factor;	//bias_factor of ApplyCollisionImpulses()
+	float bias_margin;	//penetration that is left alone
+	int lane_solver;	//1 = colored batches are solved SAT_SOLVER_LANES contacts at a time by the simd kernels. on by default
+	int block_solver;	//1 = the contacts of a manifold are solved together as one small LCP. replaces the lane solver
+	int split_impulse;	//1 = penetration is pushed out with pseudo velocities that only move the positions, the velocity iterations get no bias
+	int split_iterations;	//sweeps of the pseudo velocity pass of the global solver. the pair solver makes one, like for the velocities
+	float split_bias_factor;	//fraction of the penetration the pseudo velocities remove per step
+	float split_margin;		//penetration the pseudo velocities leave alone
+};
+
+//counters of the contact solver, zero'd by the caller
+struct solver_stats_struct
+{
+	int num_solves;		//manifolds solved
+	int num_iterations;	//iterations run for all manifolds
+	int num_converged;	//manifolds that reached the residual tolerance
+	int num_block_fallbacks;	//block solves that found no active set and fell back to sequential impulses
+	float max_residual;	//largest last-iteration impulse change of a manifold
+};
+
+extern struct solver_config_struct g_solver_config;
+extern struct solver_stats_struct g_solver_stats;
+
+/*Global contact solver*/
+//velocities of a body while the contacts are solved
+struct solver_body_struct
+{
+	float inv_mass;
+	float inv_inertia[9];	//world space
+	float linear_vel[3];
+	float angular_vel[3];
+	float angular_momentum[3];	//gets the total impulses of the contacts once the iterations are done
+	float split_linear_vel[3];	//pseudo velocities of the split impulse pass
+	float split_angular_vel[3];
+	int is_used;	//1 if a contact row refers to the body, only those are written back
+};
+
+//one contact, with everything that doesn't change during the iterations
+struct solver_contact_struct
+{
+	int i_body[2];		//-1 for the ground, which has infinite mass
+	float normal[3];	//from body 1 to body 0
+	float r[2][3];		//from each body's center to the contact
+	float rxn[2][3];	//r cross normal, the angular momentum of a unit impulse
+	float inv_i_rxn[2][3];	//angular velocity of a unit impulse
+	float inv_k;		//1/effective mass along the normal
+	float bias;			//penetration recovery velocity, 0 with the split impulse
+	float impulse;		//accumulated impulse
+	float split_bias;	//pseudo velocity the split impulse pushes the bodies apart with
+	float split_impulse;	//accumulated impulse of the split impulse pass
+	struct contact_info_struct * contact;	//gets the final impulse
+};
+
+#define SAT_SOLVER_MAX_COLORS 64	//manifolds that don't get one of these colors are solved after the others on one thread
+#define SAT_SOLVER_TASK_MANIFOLDS 32	//fewest manifolds of a batch handed to one thread pool task
+#define SAT_SOLVER_LANES 8	//contacts of different manifolds solved side by side, the avx2 width
+//fraction of each contact's effective mass term added to the diagonal of the block solver. without it the 4 contacts of a face have no unique impulses
+#define SAT_BLOCK_REGULARIZATION 1e-3f
+//the block solver drops a set of active contacts whose pivot is below this fraction of the largest effective mass term
+#define SAT_BLOCK_PIVOT_EPSILON 1e-6
+//and accepts a solution where the inactive contacts approach at most this fraction of the largest velocity term
+#define SAT_BLOCK_VEL_EPSILON 1e-5f
+
+//rows of a lane block. each row is SAT_SOLVER_LANES floats, one per contact
+#define SAT_LANE_NORMAL 0	//x, y and z rows
+#define SAT_LANE_R0 3
+#define SAT_LANE_R1 6
+#define SAT_LANE_INV_I_RXN0 9
+#define SAT_LANE_INV_I_RXN1 12
+#define SAT_LANE_INV_MASS0 15
+#define SAT_LANE_INV_MASS1 16
+#define SAT_LANE_INV_K 17
+#define SAT_LANE_BIAS 18
+#define SAT_LANE_IMPULSE 19
+#define SAT_LANE_FIELDS 20
+
+//contact rows of all pairs of a step
+struct contact_solver_struct
+{
+	struct thread_pool_struct * pool;	//0 = single threaded
+	struct box_struct ** bodies;	//body array given to ContactSolverBegin()
+	float dt;		//seconds of the step being solved
+	struct solver_body_struct * solver_bodies;	//one per body
+	uint64_t * body_colors;		//colors taken by the manifolds of each body
+	int num_bodies;
+	int max_bodies;
+	struct solver_contact_struct * contacts;
+	int num_contacts;
+	int max_contacts;
+	int * manifold_rows;	//rows of manifold m are manifold_rows[m] .. manifold_rows[m+1]-1
+	int * manifold_bodies;	//2 per manifold, -1 for the ground
+	int * manifold_colors;	//SAT_SOLVER_MAX_COLORS for manifolds in the last batch
+	int * batch_manifolds;	//manifolds sorted by color
+	int * batch_first;		//manifolds of batch c are batch_manifolds[batch_first[c]] .. batch_first[c+1]-1
+	int num_batches;
+	int num_manifolds;
+	int max_manifolds;
+	float * task_residuals;	//largest impulse change of each task of a batch
+	int * task_fallbacks;	//block solves of each task that fell back to sequential impulses
+	int max_tasks;
+	int i_batch;			//batch the tasks are working on
+	int num_tasks;
+	float * lane_rows;		//SAT_LANE_FIELDS*SAT_SOLVER_LANES floats per block, aligned for the simd kernels
+	int * lane_contacts;	//SAT_SOLVER_LANES per block, the row each lane was copied from or -1
+	int num_blocks;
+	int max_blocks;
+	int * group_blocks;		//blocks of lane group g are group_blocks[g] .. group_blocks[g+1]-1, one per contact slot
+	int * group_bodies;		//2*SAT_SOLVER_LANES per group, body 0 of each lane then body 1. -1 for the ground and empty lanes
+	int * batch_groups;		//lane groups of batch c are batch_groups[c] .. batch_groups[c+1]-1
+	int num_groups;
+	int max_groups;
+	int use_lanes;			//1 while the colored batches are solved from the lane blocks
+	int split_pass;			//1 while the batches solve the pseudo velocities of the split impulse
+};
+
+/*Shapes*/
+//one immutable hull per kind of shape, in the body's frame. bodies refer to them by handle.
+struct shape_registry_struct
+{
+	struct box_collision_struct ** hulls;	//each hull is allocated on its own so the pointers stay valid
+	int num_shapes;
+	int max_shapes;
+};
+
+//world space copies of one shape for the bodies that want them, allocated in one block per array
+struct hull_pool_struct
+{
+	struct box_collision_struct * hulls;
+	float * positions;
+	struct face_struct * faces;
+	struct edge_struct * edges;
+	struct gauss_arc_struct * arcs;
+	float * soa;
+	int num_hulls;
+};
+
+/*Hull builder*/
+//what BuildHull() did
+struct hull_build_stats_struct
+{
+	int num_input_points;
+	int num_welded;			//input points dropped as duplicates
+	int num_hull_triangles;	//triangles of the quickhull mesh
+	int num_merged;			//triangles that were merged away into coplanar faces
+	int num_removed_verts;	//vertices left on an edge or inside a face by the merge
+	double build_ms;
+	int temp_bytes;			//peak scratch memory
+	int hull_bytes;			//HullMemorySize() of the result
+};
+
+/*SIMD levels for the support kernels*/
+#define SAT_SIMD_SCALAR 0
+#define SAT_SIMD_SSE 1		//SSE4.1
+#define SAT_SIMD_AVX2 2
+#define SAT_SIMD_WIDTH 8	//hull soa arrays are padded to a multiple of the widest kernel
+
+/*Hull functions (sat_hull.c)*/
+int InitHull(float * positions, int num_positions, struct box_collision_struct * phull);
+int InitPlaneHull(float * positions, int num_positions, struct box_collision_struct * phull);
+void UpdateHull(struct box_collision_struct * base_hull, struct box_struct * box);
+int CopyHull(struct box_collision_struct * dest, struct box_collision_struct * src);
+void InitHullBoxExtents(struct box_collision_struct * phull);
+int InitHullSoa(struct box_collision_struct * hull);
+void UpdateHullSoa(struct box_collision_struct * hull);
+int InitHullAxisGroups(struct box_collision_struct * hull);
+int InitHullArcs(struct box_collision_struct * hull);
+int InitHullAdjacency(struct box_collision_struct * hull);
+int InitHullHalfEdges(struct box_collision_struct * hull);
+int FindSupportHillClimb(struct box_collision_struct * hull, float * dir, int i_start, float * min_dot);
+void FreeHull(struct box_collision_struct * hull);
+int HullMemorySize(struct box_collision_struct * hull);
+void HullGetPosition(struct box_struct * box, int i_vertex, float * pos);
+void HullGetFaceNormal(struct box_struct * box, int i_face, float * normal);
+void HullGetEdgeNormal(struct box_struct * box, int i_edge, float * normal);
+void HullToLocalDir(struct box_struct * box, float * dir, float * local_dir);
+void ProjectHull(struct box_struct * box, float * dir, float * min_dot, float * max_dot);
+void ProjectHullWarm(struct box_struct * box, float * dir, float * min_dot, float * max_dot, int * warm);
+int HullFindSupport(struct box_struct * box, float * dir, int * warm, float * min_dot);
+
+/*Hull builder functions (sat_quickhull.c)*/
+int BuildHull(float * points, int num_points, struct box_collision_struct * phull, struct hull_build_stats_struct * stats);
+
+/*Shape functions (sat_shape.c)*/
+int ShapeRegistryInit(struct shape_registry_struct * registry);
+void ShapeRegistryFree(struct shape_registry_struct * registry);
+int ShapeRegister(struct shape_registry_struct * registry, struct box_collision_struct * hull);
+struct box_collision_struct * ShapeGetHull(struct shape_registry_struct * registry, int shape);
+void SetBodyShape(struct shape_registry_struct * registry, struct box_struct * box, int shape);
+int HullPoolInit(struct hull_pool_struct * pool, struct box_collision_struct * shape_hull, int num_hulls);
+void HullPoolFree(struct hull_pool_struct * pool);
+void SetBodyWorldHull(struct hull_pool_struct * pool, struct box_struct * box, int i_hull);
+
+/*Support and contact solver kernels (sat_simd.c)*/
+int SatGetSimdLevel(void);
+int SatSetSimdLevel(int level);
+int FindSupportSoa(float * soa, int num_soa, float * dir, float * min_dot);
+void ProjectSoa(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot);
+void SolveContactLanes(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual);
+
+/*Collision functions (sat_collision.c)*/
+int FindSeparatingAxis(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min);
+int FindSeparatingAxisCached(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min, struct sat_cache_struct * cache);
+int FindSeparatingAxisBox(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min, struct sat_cache_struct * cache);
+int SelectSeparatingAxis(struct d_min_struct * d_min, struct sat_cache_struct * cache);
+int CreateEdgeContact(struct d_min_struct * d_min, struct box_struct * boxA, struct box_struct * boxB, struct contact_manifold_struct * contact_manifold);
+int CreateFaceContact(struct d_min_struct * d_min, struct box_struct * boxA, struct box_struct * boxB, struct contact_manifold_struct * contact_manifold);
+
+/*Broadphase functions (sat_broadphase.c)*/
+void CalculateHullAabb(struct box_struct * box, struct aabb_struct * aabb);
+int AabbOverlap(struct aabb_struct * a, struct aabb_struct * b);
+int AddBroadphasePair(struct broadphase_pair_struct ** pairs, int * num_pairs, int * max_pairs, int i_bodyA, int i_bodyB);
+void SortBroadphasePairs(struct broadphase_pair_struct * pairs, int num_pairs);
+void SapInit(struct sap_struct * sap);
+void SapFree(struct sap_struct * sap);
+int SapUpdate(struct sap_struct * sap, struct box_struct ** bodies, int num_bodies);
+
+/*Dynamic aabb tree functions (sat_bvh.c)*/
+void BvhInit(struct bvh_struct * bvh, float margin);
+void BvhFree(struct bvh_struct * bvh);
+int BvhInsert(struct bvh_struct * bvh, int i_body, struct aabb_struct * aabb);
+void BvhRemove(struct bvh_struct * bvh, int proxy);
+int BvhMove(struct bvh_struct * bvh, int proxy, struct aabb_struct * aabb);
+int BvhUpdate(struct bvh_struct * bvh, struct box_struct ** bodies, int num_bodies);
+int BvhQueryAabb(struct bvh_struct * bvh, struct aabb_struct * aabb, int * results, int max_results);
+int BvhRayCast(struct bvh_struct * bvh, struct box_struct ** bodies, float * origin, float * dir, float max_t, float * t_hit);
+int RayCastHull(struct box_struct * box, float * origin, float * dir, float max_t, float * t_hit);
+
+/*Pair cache functions (sat_pair_cache.c)*/
+int PairCacheInit(struct pair_cache_struct * cache, int max_entries);
+void PairCacheFree(struct pair_cache_struct * cache);
+struct pair_cache_entry_struct * PairCacheGet(struct pair_cache_struct * cache, struct box_struct * bodyA, struct box_struct * bodyB);
+void PairCacheEndStep(struct pair_cache_struct * cache);
+int PairCacheReserve(struct pair_cache_struct * cache, int num_new_entries);
+
+/*Contact manifold functions (sat_manifold.c)*/
+void ContactSetLocalPoints(struct contact_info_struct * contact, struct box_struct * boxA, struct box_struct * boxB, float * pointA, float * pointB);
+int ManifoldRefresh(struct contact_manifold_struct * manifold, struct d_min_struct * d_min, struct box_struct * boxA, struct box_struct * boxB);
+void ManifoldUpdate(struct contact_manifold_struct * manifold, struct contact_manifold_struct * new_manifold);
+
+/*Spatial hash grid functions (sat_grid.c)*/
+void GridInit(struct grid_struct * grid, float cell_size, struct thread_pool_struct * pool);
+void GridFree(struct grid_struct * grid);
+int GridUpdate(struct grid_struct * grid, struct box_struct ** bodies, int num_bodies);
+
+/*Thread pool functions (sat_threads.c)*/
+int GetNumCpus(void);
+int ThreadPoolInit(struct thread_pool_struct * pool, int num_threads);
+void ThreadPoolFree(struct thread_pool_struct * pool);
+void ThreadPoolRun(struct thread_pool_struct * pool, void (*job)(void * user, int i_task), void * user, int num_tasks);
+void GetTaskRange(int num_items, int num_tasks, int i_task, int * start, int * end);
+
+/*Simulation functions (sat_dynamics.c)*/
+int InitObjBox(struct box_struct * pbox, float x, float y, float z);
+int InitObjPlane(struct box_struct * plane);
+void UpdateBoxSimulation(struct box_collision_struct * base_hull, struct box_struct * pbox, float dt);
+void CalculateNewBoxVelocity(struct box_struct * pbox, float * sumTorques, float * sumForces, float dt);
+void UpdateBoxVelocity(struct box_struct * box);
+void ApplyCollisionImpulses(struct box_struct * boxA, struct box_struct * boxB, struct contact_info_struct * contacts, int num_contacts, int is_b_ground, float dt);
+float CalcBaumgarteBias(float penetration, float bias_factor, float dt);
+float CalcSplitBias(float penetration, float dt);
+
+/*Global contact solver functions (sat_solver.c)*/
+void ContactSolverInit(struct contact_solver_struct * solver, struct thread_pool_struct * pool);
+void ContactSolverFree(struct contact_solver_struct * solver);
+int ContactSolverBegin(struct contact_solver_struct * solver, struct box_struct ** bodies, int num_bodies, float dt);
+int ContactSolverAddManifold(struct contact_solver_struct * solver, int i_bodyA, int i_bodyB, int is_b_ground, struct contact_manifold_struct * manifold);
+void ContactSolverSolve(struct contact_solver_struct * solver);
+
+#endif
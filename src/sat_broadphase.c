@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sat.h"
+
+static int SapResize(struct sap_struct * sap, int num_bodies);
+static int SapEndpointLess(struct sap_endpoint_struct * a, struct sap_endpoint_struct * b);
+static int ComparePairs(const void * a, const void * b);
+
+//Calculates the world aabb of a body's hull. Assumes UpdateHull() has already
+//transformed world space hulls, local hulls are projected on the world axes instead.
+void CalculateHullAabb(struct box_struct * box, struct aabb_struct * aabb)
+{
+	struct box_collision_struct * hull;
+	float axis[3];
+	float * p;
+	int i;
+	int k;
+
+	hull = box->hull;
+	if(hull->is_local == 1)
+	{
+		for(k = 0; k < 3; k++)
+		{
+			axis[0] = 0.0f;
+			axis[1] = 0.0f;
+			axis[2] = 0.0f;
+			axis[k] = 1.0f;
+			ProjectHull(box, axis, &(aabb->min[k]), &(aabb->max[k]));
+		}
+		return;
+	}
+
+	for(k = 0; k < 3; k++)
+	{
+		aabb->min[k] = hull->positions[k];
+		aabb->max[k] = hull->positions[k];
+	}
+	for(i = 1; i < hull->num_pos; i++)
+	{
+		p = hull->positions + (i*3);
+		for(k = 0; k < 3; k++)
+		{
+			if(p[k] < aabb->min[k])
+				aabb->min[k] = p[k];
+			if(p[k] > aabb->max[k])
+				aabb->max[k] = p[k];
+		}
+	}
+}
+
+//returns 1 if the boxes overlap. touching counts as overlap since the
+//ground plane aabb has no thickness.
+int AabbOverlap(struct aabb_struct * a, struct aabb_struct * b)
+{
+	if(a->max[0] < b->min[0] || b->max[0] < a->min[0])
+		return 0;
+	if(a->max[1] < b->min[1] || b->max[1] < a->min[1])
+		return 0;
+	if(a->max[2] < b->min[2] || b->max[2] < a->min[2])
+		return 0;
+	return 1;
+}
+
+//appends a pair to a growable pair array. stores the smaller body index first.
+//returns 0 if the array couldn't grow.
+int AddBroadphasePair(struct broadphase_pair_struct ** pairs, int * num_pairs, int * max_pairs, int i_bodyA, int i_bodyB)
+{
+	struct broadphase_pair_struct * new_pairs;
+	int new_max;
+
+	if(*num_pairs >= *max_pairs)
+	{
+		new_max = (*max_pairs)*2;
+		if(new_max < 64)
+			new_max = 64;
+		new_pairs = (struct broadphase_pair_struct*)realloc(*pairs, new_max*sizeof(struct broadphase_pair_struct));
+		if(new_pairs == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		*pairs = new_pairs;
+		*max_pairs = new_max;
+	}
+
+	if(i_bodyA < i_bodyB)
+	{
+		(*pairs)[*num_pairs].i_body[0] = i_bodyA;
+		(*pairs)[*num_pairs].i_body[1] = i_bodyB;
+	}
+	else
+	{
+		(*pairs)[*num_pairs].i_body[0] = i_bodyB;
+		(*pairs)[*num_pairs].i_body[1] = i_bodyA;
+	}
+	*num_pairs += 1;
+
+	return 1;
+}
+
+//Sorts pairs by (i_body[0], i_body[1]) so the narrowphase always visits
+//them in the same order no matter how the broadphase found them.
+void SortBroadphasePairs(struct broadphase_pair_struct * pairs, int num_pairs)
+{
+	//pairs can be 0 when there are none, qsort() mustn't get a null pointer
+	if(num_pairs > 1)
+		qsort(pairs, num_pairs, sizeof(struct broadphase_pair_struct), ComparePairs);
+}
+
+void SapInit(struct sap_struct * sap)
+{
+	memset(sap, 0, sizeof(struct sap_struct));
+}
+
+void SapFree(struct sap_struct * sap)
+{
+	free(sap->endpoints);
+	free(sap->aabbs);
+	free(sap->active);
+	free(sap->pairs);
+	memset(sap, 0, sizeof(struct sap_struct));
+}
+
+/*
+Updates the aabbs of all bodies, re-sorts the x endpoints and fills sap->pairs with
+the pairs of bodies whose aabbs overlap.
+-Endpoints are re-sorted with insertion sort. Since bodies only move a little each step
+ the list from the last step is nearly sorted and this is close to O(n).
+-If the number of bodies changes the endpoint list is rebuilt.
+returns 0 on failure.
+*/
+int SapUpdate(struct sap_struct * sap, struct box_struct ** bodies, int num_bodies)
+{
+	struct sap_endpoint_struct temp_endpoint;
+	struct sap_endpoint_struct * ep;
+	int num_endpoints;
+	int num_active;
+	int i_body;
+	int i;
+	int j;
+	int r;
+
+	if(num_bodies != sap->num_bodies)
+	{
+		r = SapResize(sap, num_bodies);
+		if(r == 0)
+			return 0;
+	}
+	num_endpoints = 2*num_bodies;
+
+	//refresh aabbs and the endpoint values
+	for(i = 0; i < num_bodies; i++)
+	{
+		CalculateHullAabb(bodies[i], sap->aabbs+i);
+	}
+	for(i = 0; i < num_endpoints; i++)
+	{
+		ep = sap->endpoints+i;
+		if(ep->is_max == 1)
+			ep->value = sap->aabbs[ep->i_body].max[0];
+		else
+			ep->value = sap->aabbs[ep->i_body].min[0];
+	}
+
+	//insertion sort the endpoints along x
+	for(i = 1; i < num_endpoints; i++)
+	{
+		temp_endpoint = sap->endpoints[i];
+		j = i - 1;
+		while(j >= 0 && SapEndpointLess(&temp_endpoint, sap->endpoints+j))
+		{
+			sap->endpoints[j+1] = sap->endpoints[j];
+			j -= 1;
+		}
+		sap->endpoints[j+1] = temp_endpoint;
+	}
+
+	//sweep. a body is active between its min and max endpoint, when a body
+	//starts it overlaps on x with all active bodies so only y,z need checking.
+	sap->num_pairs = 0;
+	num_active = 0;
+	for(i = 0; i < num_endpoints; i++)
+	{
+		ep = sap->endpoints+i;
+		i_body = ep->i_body;
+		if(ep->is_max == 0)
+		{
+			for(j = 0; j < num_active; j++)
+			{
+				if(AabbOverlap(sap->aabbs+i_body, sap->aabbs+sap->active[j]) == 1)
+				{
+					r = AddBroadphasePair(&(sap->pairs), &(sap->num_pairs), &(sap->max_pairs), i_body, sap->active[j]);
+					if(r == 0)
+						return 0;
+				}
+			}
+			sap->active[num_active] = i_body;
+			num_active += 1;
+		}
+		else
+		{
+			//remove the body from the active list. keep the order so the
+			//pair output doesn't depend on removal order.
+			for(j = 0; j < num_active; j++)
+			{
+				if(sap->active[j] == i_body)
+					break;
+			}
+			for(; j < (num_active-1); j++)
+			{
+				sap->active[j] = sap->active[j+1];
+			}
+			num_active -= 1;
+		}
+	}
+
+	SortBroadphasePairs(sap->pairs, sap->num_pairs);
+
+	return 1;
+}
+
+static int SapResize(struct sap_struct * sap, int num_bodies)
+{
+	int i;
+
+	if(num_bodies > sap->max_bodies)
+	{
+		free(sap->endpoints);
+		free(sap->aabbs);
+		free(sap->active);
+		sap->endpoints = (struct sap_endpoint_struct*)malloc(2*num_bodies*sizeof(struct sap_endpoint_struct));
+		sap->aabbs = (struct aabb_struct*)malloc(num_bodies*sizeof(struct aabb_struct));
+		sap->active = (int*)malloc(num_bodies*sizeof(int));
+		if(sap->endpoints == 0 || sap->aabbs == 0 || sap->active == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			sap->max_bodies = 0;
+			sap->num_bodies = 0;
+			return 0;
+		}
+		sap->max_bodies = num_bodies;
+	}
+
+	for(i = 0; i < num_bodies; i++)
+	{
+		sap->endpoints[(i*2)].i_body = i;
+		sap->endpoints[(i*2)].is_max = 0;
+		sap->endpoints[(i*2)].value = 0.0f;
+		sap->endpoints[(i*2)+1].i_body = i;
+		sap->endpoints[(i*2)+1].is_max = 1;
+		sap->endpoints[(i*2)+1].value = 0.0f;
+	}
+	sap->num_bodies = num_bodies;
+
+	return 1;
+}
+
+//ordering of endpoints. On equal values min endpoints go before max endpoints
+//so that touching intervals are reported as overlapping.
+static int SapEndpointLess(struct sap_endpoint_struct * a, struct sap_endpoint_struct * b)
+{
+	if(a->value != b->value)
+		return (a->value < b->value);
+	if(a->is_max != b->is_max)
+		return (a->is_max < b->is_max);
+	return (a->i_body < b->i_body);
+}
+
+static int ComparePairs(const void * a, const void * b)
+{
+	const struct broadphase_pair_struct * pa = (const struct broadphase_pair_struct*)a;
+	const struct broadphase_pair_struct * pb = (const struct broadphase_pair_struct*)b;
+
+	if(pa->i_body[0] != pb->i_body[0])
+		return (pa->i_body[0] - pb->i_body[0]);
+	return (pa->i_body[1] - pb->i_body[1]);
+}
@@ -0,0 +1,745 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+
+static int BvhAllocNode(struct bvh_struct * bvh);
+static void BvhFreeNode(struct bvh_struct * bvh, int i_node);
+static void BvhInsertLeaf(struct bvh_struct * bvh, int leaf);
+static void BvhRemoveLeaf(struct bvh_struct * bvh, int leaf);
+static int BvhBalance(struct bvh_struct * bvh, int iA);
+static int BvhPush(struct bvh_struct * bvh, int * num_stack, int i_node);
+static int BvhResize(struct bvh_struct * bvh, int num_bodies);
+static void AabbUnion(struct aabb_struct * result, struct aabb_struct * a, struct aabb_struct * b);
+static float AabbSurfaceArea(struct aabb_struct * a);
+static int AabbContains(struct aabb_struct * outer, struct aabb_struct * inner);
+static int RayAabb(struct aabb_struct * aabb, float * origin, float * dir, float max_t);
+
+void BvhInit(struct bvh_struct * bvh, float margin)
+{
+	memset(bvh, 0, sizeof(struct bvh_struct));
+	bvh->root = BVH_NULL_NODE;
+	bvh->free_list = BVH_NULL_NODE;
+	bvh->margin = margin;
+}
+
+void BvhFree(struct bvh_struct * bvh)
+{
+	free(bvh->nodes);
+	free(bvh->proxies);
+	free(bvh->aabbs);
+	free(bvh->stack);
+	free(bvh->pairs);
+	memset(bvh, 0, sizeof(struct bvh_struct));
+	bvh->root = BVH_NULL_NODE;
+	bvh->free_list = BVH_NULL_NODE;
+}
+
+//Creates a leaf for body i_body with a fat version of aabb.
+//returns the leaf node (the body's proxy) or BVH_NULL_NODE on failure.
+int BvhInsert(struct bvh_struct * bvh, int i_body, struct aabb_struct * aabb)
+{
+	struct bvh_node_struct * node;
+	int leaf;
+	int k;
+
+	leaf = BvhAllocNode(bvh);
+	if(leaf == BVH_NULL_NODE)
+		return BVH_NULL_NODE;
+
+	node = bvh->nodes+leaf;
+	for(k = 0; k < 3; k++)
+	{
+		node->aabb.min[k] = aabb->min[k] - bvh->margin;
+		node->aabb.max[k] = aabb->max[k] + bvh->margin;
+	}
+	node->i_body = i_body;
+	node->height = 0;
+
+	BvhInsertLeaf(bvh, leaf);
+
+	return leaf;
+}
+
+void BvhRemove(struct bvh_struct * bvh, int proxy)
+{
+	BvhRemoveLeaf(bvh, proxy);
+	BvhFreeNode(bvh, proxy);
+}
+
+/*
+Refits a body's leaf to its new tight aabb. If the tight aabb is still inside the
+fat aabb nothing in the tree changes, otherwise the leaf is re-inserted with a new
+fat aabb.
+returns 1 if the leaf was re-inserted.
+*/
+int BvhMove(struct bvh_struct * bvh, int proxy, struct aabb_struct * aabb)
+{
+	struct bvh_node_struct * node;
+	int k;
+
+	node = bvh->nodes+proxy;
+	if(AabbContains(&(node->aabb), aabb) == 1)
+		return 0;
+
+	BvhRemoveLeaf(bvh, proxy);
+	node = bvh->nodes+proxy;
+	for(k = 0; k < 3; k++)
+	{
+		node->aabb.min[k] = aabb->min[k] - bvh->margin;
+		node->aabb.max[k] = aabb->max[k] + bvh->margin;
+	}
+	BvhInsertLeaf(bvh, proxy);
+
+	return 1;
+}
+
+/*
+Refits the tree to the current hull positions and fills bvh->pairs with pairs of
+bodies whose tight aabbs overlap. If the number of bodies changes the tree is
+rebuilt.
+returns 0 on failure.
+*/
+int BvhUpdate(struct bvh_struct * bvh, struct box_struct ** bodies, int num_bodies)
+{
+	struct bvh_node_struct * node;
+	int num_stack;
+	int i_node;
+	int j_body;
+	int i;
+	int r;
+
+	if(num_bodies != bvh->num_bodies)
+	{
+		r = BvhResize(bvh, num_bodies);
+		if(r == 0)
+			return 0;
+		for(i = 0; i < num_bodies; i++)
+		{
+			CalculateHullAabb(bodies[i], bvh->aabbs+i);
+			bvh->proxies[i] = BvhInsert(bvh, i, bvh->aabbs+i);
+			if(bvh->proxies[i] == BVH_NULL_NODE)
+				return 0;
+		}
+		bvh->num_reinserted = num_bodies;
+	}
+	else
+	{
+		bvh->num_reinserted = 0;
+		for(i = 0; i < num_bodies; i++)
+		{
+			CalculateHullAabb(bodies[i], bvh->aabbs+i);
+			bvh->num_reinserted += BvhMove(bvh, bvh->proxies[i], bvh->aabbs+i);
+		}
+	}
+
+	//query the tree with each body's tight aabb. Only keep j_body > i so
+	//each pair is found once.
+	bvh->num_pairs = 0;
+	for(i = 0; i < num_bodies; i++)
+	{
+		num_stack = 0;
+		if(BvhPush(bvh, &num_stack, bvh->root) == 0)
+			return 0;
+		while(num_stack > 0)
+		{
+			num_stack -= 1;
+			i_node = bvh->stack[num_stack];
+			node = bvh->nodes+i_node;
+			if(AabbOverlap(&(node->aabb), bvh->aabbs+i) == 0)
+				continue;
+
+			if(node->height == 0)
+			{
+				j_body = node->i_body;
+				if(j_body > i && AabbOverlap(bvh->aabbs+i, bvh->aabbs+j_body) == 1)
+				{
+					r = AddBroadphasePair(&(bvh->pairs), &(bvh->num_pairs), &(bvh->max_pairs), i, j_body);
+					if(r == 0)
+						return 0;
+				}
+			}
+			else
+			{
+				if(BvhPush(bvh, &num_stack, node->child[0]) == 0)
+					return 0;
+				if(BvhPush(bvh, &num_stack, node->child[1]) == 0)
+					return 0;
+			}
+		}
+	}
+
+	SortBroadphasePairs(bvh->pairs, bvh->num_pairs);
+
+	return 1;
+}
+
+//Finds the bodies whose fat aabb overlaps aabb. Up to max_results body indices
+//are written to results.
+//returns the total # of bodies found, which can be larger than max_results.
+int BvhQueryAabb(struct bvh_struct * bvh, struct aabb_struct * aabb, int * results, int max_results)
+{
+	struct bvh_node_struct * node;
+	int num_stack=0;
+	int num_found=0;
+	int i_node;
+
+	if(BvhPush(bvh, &num_stack, bvh->root) == 0)
+		return 0;
+	while(num_stack > 0)
+	{
+		num_stack -= 1;
+		i_node = bvh->stack[num_stack];
+		node = bvh->nodes+i_node;
+		if(AabbOverlap(&(node->aabb), aabb) == 0)
+			continue;
+
+		if(node->height == 0)
+		{
+			if(num_found < max_results)
+				results[num_found] = node->i_body;
+			num_found += 1;
+		}
+		else
+		{
+			if(BvhPush(bvh, &num_stack, node->child[0]) == 0)
+				return num_found;
+			if(BvhPush(bvh, &num_stack, node->child[1]) == 0)
+				return num_found;
+		}
+	}
+
+	return num_found;
+}
+
+/*
+Casts the ray origin + t*dir, 0 <= t <= max_t against the hulls of the bodies in the
+tree. The tree is only used to skip bodies; hits are exact against the hull faces.
+returns the index of the closest body hit and sets t_hit, or -1 if nothing was hit.
+*/
+int BvhRayCast(struct bvh_struct * bvh, struct box_struct ** bodies, float * origin, float * dir, float max_t, float * t_hit)
+{
+	struct bvh_node_struct * node;
+	float t;
+	int num_stack=0;
+	int i_node;
+	int i_hit=-1;
+
+	if(BvhPush(bvh, &num_stack, bvh->root) == 0)
+		return -1;
+	while(num_stack > 0)
+	{
+		num_stack -= 1;
+		i_node = bvh->stack[num_stack];
+		node = bvh->nodes+i_node;
+
+		//max_t shrinks as hits are found so farther nodes get culled
+		if(RayAabb(&(node->aabb), origin, dir, max_t) == 0)
+			continue;
+
+		if(node->height == 0)
+		{
+			if(RayCastHull(bodies[node->i_body], origin, dir, max_t, &t) == 1)
+			{
+				max_t = t;
+				i_hit = node->i_body;
+			}
+		}
+		else
+		{
+			if(BvhPush(bvh, &num_stack, node->child[0]) == 0)
+				break;
+			if(BvhPush(bvh, &num_stack, node->child[1]) == 0)
+				break;
+		}
+	}
+
+	if(i_hit != -1)
+		*t_hit = max_t;
+	return i_hit;
+}
+
+/*
+Ray against the convex hull of a body in world space. Clips the ray against every face plane.
+returns 1 if the hull is hit between 0 and max_t, t_hit is set to the entry point.
+*/
+int RayCastHull(struct box_struct * box, float * origin, float * dir, float max_t, float * t_hit)
+{
+	struct box_collision_struct * hull;
+	struct face_struct * face;
+	float temp_vec[3];
+	float local_origin[3];
+	float local_dir[3];
+	float t_enter = 0.0f;
+	float t_exit;
+	float denom;
+	float dist;
+	float t;
+	int i;
+
+	//a local hull is tested with the ray moved into its frame, t doesn't change
+	hull = box->hull;
+	if(hull->is_local == 1)
+	{
+		vSubtract(temp_vec, origin, box->pos);
+		HullToLocalDir(box, temp_vec, local_origin);
+		HullToLocalDir(box, dir, local_dir);
+		origin = local_origin;
+		dir = local_dir;
+	}
+
+	t_exit = max_t;
+	for(i = 0; i < hull->num_faces; i++)
+	{
+		face = hull->faces+i;
+		vSubtract(temp_vec, origin, (hull->positions+(face->i_vertices[0]*3)));
+		dist = vDotProduct(face->normal, temp_vec);	//> 0 means origin is outside of this face
+		denom = vDotProduct(face->normal, dir);
+		if(denom == 0.0f)
+		{
+			if(dist > 0.0f)
+				return 0;	//parallel to the face and outside of it
+			continue;
+		}
+		t = -dist/denom;
+		if(denom < 0.0f)
+		{
+			if(t > t_enter)
+				t_enter = t;
+		}
+		else
+		{
+			if(t < t_exit)
+				t_exit = t;
+		}
+		if(t_enter > t_exit)
+			return 0;
+	}
+
+	*t_hit = t_enter;
+	return 1;
+}
+
+static int BvhAllocNode(struct bvh_struct * bvh)
+{
+	struct bvh_node_struct * new_nodes;
+	int new_max;
+	int i_node;
+	int i;
+
+	//grow the node pool and put the new nodes on the free list
+	if(bvh->free_list == BVH_NULL_NODE)
+	{
+		new_max = bvh->max_nodes*2;
+		if(new_max < 16)
+			new_max = 16;
+		new_nodes = (struct bvh_node_struct*)realloc(bvh->nodes, new_max*sizeof(struct bvh_node_struct));
+		if(new_nodes == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return BVH_NULL_NODE;
+		}
+		bvh->nodes = new_nodes;
+		for(i = bvh->max_nodes; i < new_max; i++)
+		{
+			bvh->nodes[i].next = i+1;
+			bvh->nodes[i].height = -1;
+		}
+		bvh->nodes[new_max-1].next = BVH_NULL_NODE;
+		bvh->free_list = bvh->max_nodes;
+		bvh->max_nodes = new_max;
+	}
+
+	i_node = bvh->free_list;
+	bvh->free_list = bvh->nodes[i_node].next;
+	bvh->nodes[i_node].parent = BVH_NULL_NODE;
+	bvh->nodes[i_node].child[0] = BVH_NULL_NODE;
+	bvh->nodes[i_node].child[1] = BVH_NULL_NODE;
+	bvh->nodes[i_node].next = BVH_NULL_NODE;
+	bvh->nodes[i_node].height = 0;
+	bvh->nodes[i_node].i_body = -1;
+	bvh->num_nodes += 1;
+
+	return i_node;
+}
+
+static void BvhFreeNode(struct bvh_struct * bvh, int i_node)
+{
+	bvh->nodes[i_node].next = bvh->free_list;
+	bvh->nodes[i_node].height = -1;
+	bvh->free_list = i_node;
+	bvh->num_nodes -= 1;
+}
+
+/*
+Picks the sibling for the new leaf by walking down from the root and taking the
+child with the smaller increase in surface area. Stops when making a new parent
+at the current node is cheaper than descending.
+*/
+static void BvhInsertLeaf(struct bvh_struct * bvh, int leaf)
+{
+	struct aabb_struct leaf_aabb;
+	struct aabb_struct combined;
+	struct bvh_node_struct * node;
+	float area;
+	float combined_area;
+	float cost;
+	float inheritance_cost;
+	float child_cost[2];
+	int i_node;
+	int sibling;
+	int old_parent;
+	int new_parent;
+	int child;
+	int k;
+
+	if(bvh->root == BVH_NULL_NODE)
+	{
+		bvh->root = leaf;
+		bvh->nodes[leaf].parent = BVH_NULL_NODE;
+		return;
+	}
+
+	leaf_aabb = bvh->nodes[leaf].aabb;
+	i_node = bvh->root;
+	while(bvh->nodes[i_node].height > 0)
+	{
+		node = bvh->nodes+i_node;
+		area = AabbSurfaceArea(&(node->aabb));
+		AabbUnion(&combined, &(node->aabb), &leaf_aabb);
+		combined_area = AabbSurfaceArea(&combined);
+
+		//cost of making a new parent for this node and the leaf
+		cost = 2.0f*combined_area;
+		//min cost of pushing the leaf further down the tree
+		inheritance_cost = 2.0f*(combined_area - area);
+
+		for(k = 0; k < 2; k++)
+		{
+			child = node->child[k];
+			AabbUnion(&combined, &leaf_aabb, &(bvh->nodes[child].aabb));
+			if(bvh->nodes[child].height == 0)
+				child_cost[k] = AabbSurfaceArea(&combined) + inheritance_cost;
+			else
+				child_cost[k] = (AabbSurfaceArea(&combined) - AabbSurfaceArea(&(bvh->nodes[child].aabb))) + inheritance_cost;
+		}
+
+		if(cost < child_cost[0] && cost < child_cost[1])
+			break;
+
+		if(child_cost[0] < child_cost[1])
+			i_node = node->child[0];
+		else
+			i_node = node->child[1];
+	}
+	sibling = i_node;
+
+	//BvhAllocNode() can move the node array, so only use indices across it
+	old_parent = bvh->nodes[sibling].parent;
+	new_parent = BvhAllocNode(bvh);
+	if(new_parent == BVH_NULL_NODE)
+		return;
+	bvh->nodes[new_parent].parent = old_parent;
+	AabbUnion(&(bvh->nodes[new_parent].aabb), &leaf_aabb, &(bvh->nodes[sibling].aabb));
+	bvh->nodes[new_parent].height = bvh->nodes[sibling].height + 1;
+	bvh->nodes[new_parent].child[0] = sibling;
+	bvh->nodes[new_parent].child[1] = leaf;
+	bvh->nodes[sibling].parent = new_parent;
+	bvh->nodes[leaf].parent = new_parent;
+
+	if(old_parent != BVH_NULL_NODE)
+	{
+		if(bvh->nodes[old_parent].child[0] == sibling)
+			bvh->nodes[old_parent].child[0] = new_parent;
+		else
+			bvh->nodes[old_parent].child[1] = new_parent;
+	}
+	else
+	{
+		bvh->root = new_parent;
+	}
+
+	//walk back up fixing heights and aabbs
+	i_node = bvh->nodes[leaf].parent;
+	while(i_node != BVH_NULL_NODE)
+	{
+		i_node = BvhBalance(bvh, i_node);
+		node = bvh->nodes+i_node;
+		node->height = 1 + (int)fmax(bvh->nodes[node->child[0]].height, bvh->nodes[node->child[1]].height);
+		AabbUnion(&(node->aabb), &(bvh->nodes[node->child[0]].aabb), &(bvh->nodes[node->child[1]].aabb));
+		i_node = node->parent;
+	}
+}
+
+static void BvhRemoveLeaf(struct bvh_struct * bvh, int leaf)
+{
+	struct bvh_node_struct * node;
+	int parent;
+	int grand_parent;
+	int sibling;
+	int i_node;
+
+	if(leaf == bvh->root)
+	{
+		bvh->root = BVH_NULL_NODE;
+		return;
+	}
+
+	parent = bvh->nodes[leaf].parent;
+	grand_parent = bvh->nodes[parent].parent;
+	if(bvh->nodes[parent].child[0] == leaf)
+		sibling = bvh->nodes[parent].child[1];
+	else
+		sibling = bvh->nodes[parent].child[0];
+
+	if(grand_parent != BVH_NULL_NODE)
+	{
+		//the sibling takes the parent's place
+		if(bvh->nodes[grand_parent].child[0] == parent)
+			bvh->nodes[grand_parent].child[0] = sibling;
+		else
+			bvh->nodes[grand_parent].child[1] = sibling;
+		bvh->nodes[sibling].parent = grand_parent;
+		BvhFreeNode(bvh, parent);
+
+		i_node = grand_parent;
+		while(i_node != BVH_NULL_NODE)
+		{
+			i_node = BvhBalance(bvh, i_node);
+			node = bvh->nodes+i_node;
+			node->height = 1 + (int)fmax(bvh->nodes[node->child[0]].height, bvh->nodes[node->child[1]].height);
+			AabbUnion(&(node->aabb), &(bvh->nodes[node->child[0]].aabb), &(bvh->nodes[node->child[1]].aabb));
+			i_node = node->parent;
+		}
+	}
+	else
+	{
+		bvh->root = sibling;
+		bvh->nodes[sibling].parent = BVH_NULL_NODE;
+		BvhFreeNode(bvh, parent);
+	}
+	bvh->nodes[leaf].parent = BVH_NULL_NODE;
+}
+
+/*
+If one child of node iA is more than 1 level taller than the other, rotate the taller
+child up to take iA's place.
+returns the index of the node that is now at iA's position in the tree.
+*/
+static int BvhBalance(struct bvh_struct * bvh, int iA)
+{
+	struct bvh_node_struct * A;
+	struct bvh_node_struct * B;
+	struct bvh_node_struct * C;
+	struct bvh_node_struct * F;
+	struct bvh_node_struct * G;
+	int iB;
+	int iC;
+	int iF;
+	int iG;
+	int balance;
+	int up;	//0 = rotate child[0] up, 1 = rotate child[1] up
+
+	A = bvh->nodes+iA;
+	if(A->height < 2)
+		return iA;
+
+	balance = bvh->nodes[A->child[1]].height - bvh->nodes[A->child[0]].height;
+	if(balance > 1)
+		up = 1;
+	else if(balance < -1)
+		up = 0;
+	else
+		return iA;
+
+	//C is the child being rotated up, B is the one staying under A
+	iC = A->child[up];
+	iB = A->child[1-up];
+	B = bvh->nodes+iB;
+	C = bvh->nodes+iC;
+	iF = C->child[0];
+	iG = C->child[1];
+	F = bvh->nodes+iF;
+	G = bvh->nodes+iG;
+
+	//swap A and C
+	C->child[0] = iA;
+	C->parent = A->parent;
+	A->parent = iC;
+	if(C->parent != BVH_NULL_NODE)
+	{
+		if(bvh->nodes[C->parent].child[0] == iA)
+			bvh->nodes[C->parent].child[0] = iC;
+		else
+			bvh->nodes[C->parent].child[1] = iC;
+	}
+	else
+	{
+		bvh->root = iC;
+	}
+
+	//the taller grandchild stays with C, the other goes to A
+	if(F->height > G->height)
+	{
+		C->child[1] = iF;
+		A->child[up] = iG;
+		G->parent = iA;
+		AabbUnion(&(A->aabb), &(B->aabb), &(G->aabb));
+		AabbUnion(&(C->aabb), &(A->aabb), &(F->aabb));
+		A->height = 1 + (int)fmax(B->height, G->height);
+		C->height = 1 + (int)fmax(A->height, F->height);
+	}
+	else
+	{
+		C->child[1] = iG;
+		A->child[up] = iF;
+		F->parent = iA;
+		AabbUnion(&(A->aabb), &(B->aabb), &(F->aabb));
+		AabbUnion(&(C->aabb), &(A->aabb), &(G->aabb));
+		A->height = 1 + (int)fmax(B->height, F->height);
+		C->height = 1 + (int)fmax(A->height, G->height);
+	}
+
+	return iC;
+}
+
+//pushes i_node on the traversal stack, growing it if needed.
+//returns 0 if the stack couldn't grow.
+static int BvhPush(struct bvh_struct * bvh, int * num_stack, int i_node)
+{
+	int * new_stack;
+	int new_max;
+
+	if(i_node == BVH_NULL_NODE)
+		return 1;
+
+	if(*num_stack >= bvh->max_stack)
+	{
+		new_max = bvh->max_stack*2;
+		if(new_max < 64)
+			new_max = 64;
+		new_stack = (int*)realloc(bvh->stack, new_max*sizeof(int));
+		if(new_stack == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		bvh->stack = new_stack;
+		bvh->max_stack = new_max;
+	}
+	bvh->stack[*num_stack] = i_node;
+	*num_stack += 1;
+
+	return 1;
+}
+
+//clears the tree and sizes the per-body arrays for num_bodies
+static int BvhResize(struct bvh_struct * bvh, int num_bodies)
+{
+	int i;
+
+	//put every node back on the free list
+	bvh->root = BVH_NULL_NODE;
+	bvh->num_nodes = 0;
+	bvh->free_list = BVH_NULL_NODE;
+	for(i = bvh->max_nodes-1; i >= 0; i--)
+	{
+		bvh->nodes[i].next = bvh->free_list;
+		bvh->nodes[i].height = -1;
+		bvh->free_list = i;
+	}
+
+	if(num_bodies > bvh->max_bodies)
+	{
+		free(bvh->proxies);
+		free(bvh->aabbs);
+		bvh->proxies = (int*)malloc(num_bodies*sizeof(int));
+		bvh->aabbs = (struct aabb_struct*)malloc(num_bodies*sizeof(struct aabb_struct));
+		if(bvh->proxies == 0 || bvh->aabbs == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			bvh->max_bodies = 0;
+			bvh->num_bodies = 0;
+			return 0;
+		}
+		bvh->max_bodies = num_bodies;
+	}
+	bvh->num_bodies = num_bodies;
+
+	return 1;
+}
+
+static void AabbUnion(struct aabb_struct * result, struct aabb_struct * a, struct aabb_struct * b)
+{
+	int k;
+
+	for(k = 0; k < 3; k++)
+	{
+		result->min[k] = (a->min[k] < b->min[k]) ? a->min[k] : b->min[k];
+		result->max[k] = (a->max[k] > b->max[k]) ? a->max[k] : b->max[k];
+	}
+}
+
+static float AabbSurfaceArea(struct aabb_struct * a)
+{
+	float dx;
+	float dy;
+	float dz;
+
+	dx = a->max[0] - a->min[0];
+	dy = a->max[1] - a->min[1];
+	dz = a->max[2] - a->min[2];
+	return 2.0f*((dx*dy) + (dy*dz) + (dz*dx));
+}
+
+static int AabbContains(struct aabb_struct * outer, struct aabb_struct * inner)
+{
+	int k;
+
+	for(k = 0; k < 3; k++)
+	{
+		if(inner->min[k] < outer->min[k] || inner->max[k] > outer->max[k])
+			return 0;
+	}
+	return 1;
+}
+
+//slab test of the segment origin + t*dir, 0 <= t <= max_t
+static int RayAabb(struct aabb_struct * aabb, float * origin, float * dir, float max_t)
+{
+	float t_enter = 0.0f;
+	float t_exit;
+	float t0;
+	float t1;
+	float temp;
+	int k;
+
+	t_exit = max_t;
+	for(k = 0; k < 3; k++)
+	{
+		if(fabs(dir[k]) < 0.0000001f)
+		{
+			if(origin[k] < aabb->min[k] || origin[k] > aabb->max[k])
+				return 0;
+			continue;
+		}
+		t0 = (aabb->min[k] - origin[k])/dir[k];
+		t1 = (aabb->max[k] - origin[k])/dir[k];
+		if(t0 > t1)
+		{
+			temp = t0;
+			t0 = t1;
+			t1 = temp;
+		}
+		if(t0 > t_enter)
+			t_enter = t0;
+		if(t1 < t_exit)
+			t_exit = t1;
+		if(t_enter > t_exit)
+			return 0;
+	}
+	return 1;
+}
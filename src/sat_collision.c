@@ -0,0 +1,1187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+#include "sat_trace.h"
+
+static int SATCheckDirection(float * s_vec3, struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min);
+static void ArcToHullFrame(struct box_struct * box, struct box_struct * frame_box, struct gauss_arc_struct * arc, struct gauss_arc_struct * frame_arc);
+static int FindMinkowskiFaces(struct gauss_arc_struct * arcA, struct gauss_arc_struct * arcsB, int num_arcsB, int * i_arcs);
+static int SATEarlyOut(struct d_min_struct * d_min, struct sat_cache_struct * cache, int feature, int index0, int index1);
+static float SATFeatureSeparation(struct box_struct * boxA, struct box_struct * boxB, int feature, int index0, int index1, float * axis, int * support);
+static int FindSeparatingAxisUnique(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min, struct sat_cache_struct * cache);
+static int FindSupportingEdge(struct box_struct * box, struct axis_group_struct * group, float * s_vec3, int find_max);
+static int FindIncidentFace(struct box_struct * incidentBox, float * referenceNormal);
+static int ReduceContacts(float * points, float * penetrations, int num_points, float * normal, int * i_keep);
+
+struct sat_config_struct g_sat_config =
+{
+	0,	//early_out
+	1,	//box_path
+	1,	//unique_axes
+	1	//persistent_contacts
+};
+
+//Assume: UpdateSimulation updated the location of the hull in
+//world space.
+//struct d_min_struct d_min; //I made a struct for this because I need a way of saying in the first iteration that d_min,s_min aren't initialized.
+int FindSeparatingAxis(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min)
+{
+	return FindSeparatingAxisCached(boxA, boxB, d_min, 0);
+}
+
+/*
+Same as FindSeparatingAxis(). 'cache' holds the feature that separated the pair, or gave
+the min penetration, on the last call and can be 0.
+With g_sat_config.early_out set the cached feature is tested first and the search stops
+at the first axis that separates the hulls. In that case d_min->d_min is the separation
+along that axis and the remaining d_min fields aren't filled in.
+*/
+int FindSeparatingAxisCached(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min, struct sat_cache_struct * cache)
+{
+	struct d_min_struct face_min;
+	struct box_collision_struct * hullA;
+	struct box_collision_struct * hullB;
+	struct gauss_arc_struct frame_arc;
+	struct gauss_arc_struct * arcA;
+	float normal[3];
+	float temp_vec[3];
+	float edgeA[3];
+	float edgeB[3];
+	float point_on_plane[3];
+	float d;
+	int i;
+	int i_edge;
+	int j_edge;
+	int j_block;
+	int candidates[SAT_ARC_BLOCK];
+	int num_candidates;
+	int num_block;
+	int debug_num_edgechecks_skipped = 0;
+	int r;
+
+	//hulls can be world space copies or local (hull->is_local), normals and positions are
+	//read through the HullGet*() functions and support queries go through HullFindSupport().
+	hullA = boxA->hull;
+	hullB = boxB->hull;
+
+	if(g_sat_config.box_path == 1 && hullA->is_box == 1 && hullB->is_box == 1)
+		return FindSeparatingAxisBox(boxA, boxB, d_min, cache);
+	if(g_sat_config.unique_axes == 1 && hullA->num_face_groups > 0 && hullB->num_face_groups > 0
+		&& hullA->num_face_groups <= SAT_MAX_AXIS_GROUPS && hullB->num_face_groups <= SAT_MAX_AXIS_GROUPS)
+		return FindSeparatingAxisUnique(boxA, boxB, d_min, cache);
+
+	memset(d_min, 0, sizeof(struct d_min_struct));
+
+	//the feature found last time usually still separates the hulls, try it first
+	if(g_sat_config.early_out == 1 && cache != 0 && cache->feature != SAT_FEATURE_NONE)
+	{
+		d = SATFeatureSeparation(boxA, boxB, cache->feature, cache->index[0], cache->index[1], normal, cache->support);
+		if(d > 0.0f)
+		{
+			d_min->d_min = d;
+			memcpy(d_min->s_min, normal, 3*sizeof(float));
+			return SATEarlyOut(d_min, cache, cache->feature, cache->index[0], cache->index[1]);
+		}
+	}
+
+	//Faces are checked before edges so that an early out needs the fewest support queries. The
+	//face results are kept in face_min while the edges are checked.
+	d_min->is_initialized = 0;
+	//First check s & d for faces in hull A
+	for(i = 0; i < hullA->num_faces; i++)
+	{
+		//calculate s vec
+		//TODO: The book's treatment of s to use when checking faces seems problematic, but the pdf seems ok.
+		//book says to negate the face-normals from hullA ... but why?
+		//convection is for s to point into hullA, this is the direction that the impulse would be applied to A for any collision
+		//contact. 
+		HullGetFaceNormal(boxA, i, normal);
+		normal[0] *= -1.0f;
+		normal[1] *= -1.0f;
+		normal[2] *= -1.0f;
+
+		//printf("FindSeparatingAxis: check hullA i_face=%d\n", i);
+		d_min->cur_check = 0; //indicate to SATCheckDirection() that we are using faces to get s_min
+		r = SATCheckDirection(normal, boxA, boxB, d_min); 
+		if(r == 1) //if SATCheckDirection found a new min update the information
+		{
+			d_min->i_face = i;
+			d_min->i_hull[0] = 0; //A
+			d_min->i_hull[1] = 1; //B
+			if(g_sat_config.early_out == 1 && d_min->d_min > 0.0f)
+				return SATEarlyOut(d_min, cache, SAT_FEATURE_FACE_A, i, 0);
+		}
+	}
+
+	//Now check s & d for faces in hull B
+	for(i = 0; i < hullB->num_faces; i++)
+	{
+		HullGetFaceNormal(boxB, i, normal); //copy to normal, so that for debug I can invert the normal vector.
+		//normal[0] *= -1.0f;
+		//normal[1] *= -1.0f;
+		//normal[2] *= -1.0f;
+
+		//printf("FindSeparatingAxis: check hullB i_face=%d\n", i);
+		d_min->cur_check = 0; //indicate to SATCheckDirection() that we are using faces to get s_min
+		r = SATCheckDirection(normal, boxA, boxB, d_min);
+		if(r == 1)
+		{
+			d_min->i_face = i;
+			d_min->i_hull[0] = 1; //B
+			d_min->i_hull[1] = 0; //A
+			if(g_sat_config.early_out == 1 && d_min->d_min > 0.0f)
+				return SATEarlyOut(d_min, cache, SAT_FEATURE_FACE_B, i, 0);
+		}
+	}
+	face_min = *d_min;
+
+	memset(d_min, 0, sizeof(struct d_min_struct));
+	//Now check edges.
+	d_min->cur_check = 1; //set that we are checking edges
+	//Only edge pairs whose Gauss map arcs cross build a face of the Minkowski difference,
+	//the arcs are tested a block of B's edges at a time, in the frame of B's arcs.
+	for(i_edge = 0; i_edge < hullA->num_edges; i_edge++)
+	{
+		arcA = hullA->arcs+i_edge;
+		if(hullA->is_local == 1 || hullB->is_local == 1)
+		{
+			ArcToHullFrame(boxA, boxB, arcA, &frame_arc);
+			arcA = &frame_arc;
+		}
+		HullGetEdgeNormal(boxA, i_edge, edgeA);
+		for(j_block = 0; j_block < hullB->num_edges; j_block += SAT_ARC_BLOCK)
+		{
+			num_block = hullB->num_edges - j_block;
+			if(num_block > SAT_ARC_BLOCK)
+				num_block = SAT_ARC_BLOCK;
+			num_candidates = FindMinkowskiFaces(arcA, hullB->arcs+j_block, num_block, candidates);
+			debug_num_edgechecks_skipped += num_block - num_candidates;
+			for(i = 0; i < num_candidates; i++)
+			{
+				j_edge = j_block + candidates[i];
+				HullGetEdgeNormal(boxB, j_edge, edgeB);
+				vCrossProduct(normal, edgeA, edgeB);
+
+				//magnitude will be 0 when edges are parallel. skip this situation.
+				if(vMagnitude(normal) <= 0.001f)
+					continue;
+				if(g_sat_config.early_out == 1)
+				{
+					d = SATFeatureSeparation(boxA, boxB, SAT_FEATURE_EDGES, i_edge, j_edge, temp_vec, ((cache != 0) ? cache->support : 0));
+					if(d > 0.0f)
+					{
+						d_min->d_min = d;
+						memcpy(d_min->s_min, temp_vec, 3*sizeof(float));
+						return SATEarlyOut(d_min, cache, SAT_FEATURE_EDGES, i_edge, j_edge);
+					}
+				}
+
+				HullGetPosition(boxA, hullA->edges[i_edge].i_vertices[0], point_on_plane);
+
+				//make sure that s points towards box A's origin to keep consistent with how
+				//s is defined.
+				vSubtract(temp_vec, boxA->pos, point_on_plane);
+				d = vDotProduct(normal, temp_vec);
+				if(d < 0.0f)
+				{
+					normal[0] *= -1.0f;
+					normal[1] *= -1.0f;
+					normal[2] *= -1.0f;
+				}
+
+				vNormalize(normal);
+
+				//the gap between A's min and B's max along s, like the face axes
+				r = SATCheckDirection(normal, boxA, boxB, d_min);
+				if(r == 1)
+				{
+					d_min->i_face = -1;
+					d_min->i_edge[0] = i_edge;
+					d_min->i_edge[1] = j_edge;
+					//since this is edge don't set i_hull.
+				}
+			}
+		}
+	}
+	//we want to save the d_min and s_min and associate it with edges, This is so we can choose
+	//what kind of contact we need to make.
+	//when no edge pair builds a Minkowski face, e.g. hulls with parallel faces, the faces
+	//alone decide.
+	d_min->s_min_edges[0] = d_min->s_min[0];
+	d_min->s_min_edges[1] = d_min->s_min[1];
+	d_min->s_min_edges[2] = d_min->s_min[2];
+	d_min->d_min_edges = (d_min->is_initialized == 1) ? d_min->d_min : -FLT_MAX;
+
+	//restore the face results
+	d_min->d_min = face_min.d_min;
+	memcpy(d_min->s_min, face_min.s_min, 3*sizeof(float));
+	d_min->i_face = face_min.i_face;
+	d_min->i_hull[0] = face_min.i_hull[0];
+	d_min->i_hull[1] = face_min.i_hull[1];
+	d_min->is_initialized = face_min.is_initialized;
+	d_min->cur_check = face_min.cur_check;
+	d_min->s_min_faces[0] = d_min->s_min[0];
+	d_min->s_min_faces[1] = d_min->s_min[1];
+	d_min->s_min_faces[2] = d_min->s_min[2];
+	d_min->d_min_faces = d_min->d_min;
+
+	//TODO: Remove this debug
+	if(d_min->d_min_faces <= 0.0f)
+	{
+		SAT_DEBUG("faces has d_min=%f", d_min->d_min_faces);
+	}
+
+	//the edges are measured by the gap along their axis like the faces, so any positive
+	//result separates the hulls
+	r = SelectSeparatingAxis(d_min, cache);
+
+	//if(d_min->d_min <= 0.0f)
+	//	printf("separating axis: %d edge checks skipped.\n", debug_num_edgechecks_skipped);
+
+	SAT_VERBOSE("separating axis: r=%d d_min=%f source=%d", r, d_min->d_min, d_min->source);
+	if(d_min->source == 0)
+	{
+		SAT_VERBOSE("i_face=%d i_hull_ref=%d i_hull_inc=%d", d_min->i_face, d_min->i_hull[0], d_min->i_hull[1]);
+	}
+	if(d_min->source == 1)
+	{
+		SAT_VERBOSE("i_edge_0=%d i_edge_1=%d", d_min->i_edge[0], d_min->i_edge[1]);
+	}
+	SAT_VERBOSE("s_min: (%f,%f,%f)", d_min->s_min[0], d_min->s_min[1], d_min->s_min[2]);
+
+	return r;
+}
+
+/*
+Picks the final axis from the face and edge results in d_min (d_min_faces, s_min_faces,
+i_face, i_hull, d_min_edges, s_min_edges, i_edge) of the separating axis searches. Any
+positive separation means the hulls are separated. Otherwise the face is used unless
+the edges are better by a small bias, face contacts are more stable. The chosen
+feature is stored in 'cache', which can be 0.
+returns 1 if a separating axis was found.
+*/
+int SelectSeparatingAxis(struct d_min_struct * d_min, struct sat_cache_struct * cache)
+{
+	float ffaceWeightBias = 0.001f;
+	int r;
+
+	if(d_min->d_min_faces > 0.0f || d_min->d_min_edges > 0.0f)
+	{
+		r = 1; //found separating axis.
+		ffaceWeightBias = 0.0f; //pick the largest separation
+	}
+	else
+	{
+		r = 0; //no separating axis. found overlap.
+	}
+	if((d_min->d_min_faces+ffaceWeightBias) >= d_min->d_min_edges)
+	{
+		d_min->d_min = d_min->d_min_faces;
+		memcpy(d_min->s_min, d_min->s_min_faces, 3*sizeof(float));
+		d_min->source = 0;
+	}
+	else
+	{
+		d_min->d_min = d_min->d_min_edges;
+		memcpy(d_min->s_min, d_min->s_min_edges, 3*sizeof(float));
+		d_min->source = 1;
+	}
+
+	if(cache != 0)
+	{
+		if(d_min->source == 1)
+		{
+			cache->feature = SAT_FEATURE_EDGES;
+			cache->index[0] = d_min->i_edge[0];
+			cache->index[1] = d_min->i_edge[1];
+		}
+		else
+		{
+			cache->feature = (d_min->i_hull[0] == 0) ? SAT_FEATURE_FACE_A : SAT_FEATURE_FACE_B;
+			cache->index[0] = d_min->i_face;
+			cache->index[1] = 0;
+		}
+	}
+
+	return r;
+}
+
+/*
+Separating axis search over the axis groups of the hulls. Each face group is projected
+once and gives the separation of both of its faces, each pair of edge groups is one
+cross product axis. Faces are still visited in index order so ties resolve like the
+face loops of FindSeparatingAxisCached(). The best edge axis is resolved to the edges
+of its groups that support it.
+*/
+static int FindSeparatingAxisUnique(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min, struct sat_cache_struct * cache)
+{
+	struct box_collision_struct * hullA;
+	struct box_collision_struct * hullB;
+	struct box_collision_struct * hull;
+	struct box_struct * box;
+	float proj[SAT_MAX_AXIS_GROUPS][4];	//min, max of A then min, max of B along each group axis
+	float axis[3];
+	float center_vec[3];
+	float edge_normal[3];
+	float group_axis[3];
+	float normal[3];
+	float min_dot[2];
+	float max_dot[2];
+	float len;
+	float d;
+	int warm[2][2];		//min and max vertices of A and B from the last projection
+	int i_best[2];		//edge groups of the best edge axis
+	int is_edge_initialized=0;
+	int i_hull;
+	int g;
+	int i;
+	int j;
+
+	hullA = boxA->hull;
+	hullB = boxB->hull;
+	memset(d_min, 0, sizeof(struct d_min_struct));
+
+	//the feature found last time usually still separates the hulls, try it first
+	if(g_sat_config.early_out == 1 && cache != 0 && cache->feature != SAT_FEATURE_NONE)
+	{
+		d = SATFeatureSeparation(boxA, boxB, cache->feature, cache->index[0], cache->index[1], axis, cache->support);
+		if(d > 0.0f)
+		{
+			d_min->d_min = d;
+			memcpy(d_min->s_min, axis, 3*sizeof(float));
+			return SATEarlyOut(d_min, cache, cache->feature, cache->index[0], cache->index[1]);
+		}
+	}
+
+	//hill climbing hulls start each projection from the vertices of the last one
+	memset(warm, 0, sizeof(warm));
+	if(cache != 0)
+	{
+		warm[0][0] = cache->support[0];
+		warm[1][1] = cache->support[1];
+	}
+
+	//faces of A then faces of B. s points into A: -normal for faces of A, normal for faces of B.
+	for(i_hull = 0; i_hull < 2; i_hull++)
+	{
+		box = (i_hull == 0) ? boxA : boxB;
+		hull = box->hull;
+		for(g = 0; g < hull->num_face_groups; g++)
+		{
+			HullGetFaceNormal(box, hull->face_groups[g].i_rep, group_axis);
+			ProjectHullWarm(boxA, group_axis, &(proj[g][0]), &(proj[g][1]), warm[0]);
+			ProjectHullWarm(boxB, group_axis, &(proj[g][2]), &(proj[g][3]), warm[1]);
+		}
+		for(i = 0; i < hull->num_faces; i++)
+		{
+			g = hull->face_group[i];
+			//a face that points the same way as the group axis sees the other hull
+			//beyond the max of its own hull. both normals are in the hull's frame here.
+			if(vDotProduct(hull->faces[i].normal, hull->faces[hull->face_groups[g].i_rep].normal) > 0.0f)
+			{
+				if(i_hull == 0)
+					d = -proj[g][1] + proj[g][2];
+				else
+					d = proj[g][0] - proj[g][3];
+			}
+			else
+			{
+				if(i_hull == 0)
+					d = proj[g][0] - proj[g][3];
+				else
+					d = -proj[g][1] + proj[g][2];
+			}
+
+			if(d_min->is_initialized == 0 || d > d_min->d_min)
+			{
+				d_min->d_min = d;
+				HullGetFaceNormal(box, i, normal);
+				if(i_hull == 0)
+				{
+					d_min->s_min[0] = -normal[0];
+					d_min->s_min[1] = -normal[1];
+					d_min->s_min[2] = -normal[2];
+				}
+				else
+				{
+					memcpy(d_min->s_min, normal, 3*sizeof(float));
+				}
+				d_min->i_face = i;
+				d_min->i_hull[0] = i_hull;
+				d_min->i_hull[1] = 1-i_hull;
+				d_min->is_initialized = 1;
+				if(g_sat_config.early_out == 1 && d > 0.0f)
+					return SATEarlyOut(d_min, cache, ((i_hull == 0) ? SAT_FEATURE_FACE_A : SAT_FEATURE_FACE_B), i, 0);
+			}
+		}
+	}
+	d_min->d_min_faces = d_min->d_min;
+	memcpy(d_min->s_min_faces, d_min->s_min, 3*sizeof(float));
+
+	//one axis per pair of edge directions, pointing from B to A
+	d_min->d_min_edges = -FLT_MAX;
+	vSubtract(center_vec, boxA->pos, boxB->pos);
+	for(i = 0; i < hullA->num_edge_groups; i++)
+	{
+		HullGetEdgeNormal(boxA, hullA->edge_groups[i].i_rep, edge_normal);
+		for(j = 0; j < hullB->num_edge_groups; j++)
+		{
+			HullGetEdgeNormal(boxB, hullB->edge_groups[j].i_rep, normal);
+			vCrossProduct(axis, edge_normal, normal);
+			len = vMagnitude(axis);
+			if(len <= 0.001f)
+				continue; //parallel edges
+			if(vDotProduct(axis, center_vec) < 0.0f)
+				len = -len;
+			axis[0] /= len;
+			axis[1] /= len;
+			axis[2] /= len;
+
+			ProjectHullWarm(boxA, axis, &(min_dot[0]), &(max_dot[0]), warm[0]);
+			ProjectHullWarm(boxB, axis, &(min_dot[1]), &(max_dot[1]), warm[1]);
+			d = min_dot[0] - max_dot[1];
+			if(is_edge_initialized == 0 || d > d_min->d_min_edges)
+			{
+				d_min->d_min_edges = d;
+				memcpy(d_min->s_min_edges, axis, 3*sizeof(float));
+				i_best[0] = i;
+				i_best[1] = j;
+				is_edge_initialized = 1;
+				if(g_sat_config.early_out == 1 && d > 0.0f)
+					break;
+			}
+		}
+		if(g_sat_config.early_out == 1 && d_min->d_min_edges > 0.0f)
+			break;
+	}
+	if(is_edge_initialized == 1)
+	{
+		d_min->i_edge[0] = FindSupportingEdge(boxA, (hullA->edge_groups+i_best[0]), d_min->s_min_edges, 0);
+		d_min->i_edge[1] = FindSupportingEdge(boxB, (hullB->edge_groups+i_best[1]), d_min->s_min_edges, 1);
+		if(g_sat_config.early_out == 1 && d_min->d_min_edges > 0.0f)
+		{
+			d_min->d_min = d_min->d_min_edges;
+			memcpy(d_min->s_min, d_min->s_min_edges, 3*sizeof(float));
+			return SATEarlyOut(d_min, cache, SAT_FEATURE_EDGES, d_min->i_edge[0], d_min->i_edge[1]);
+		}
+	}
+
+	return SelectSeparatingAxis(d_min, cache);
+}
+
+//returns the edge of the group with the smallest (find_max=0) or largest (find_max=1) projection on s_vec3
+static int FindSupportingEdge(struct box_struct * box, struct axis_group_struct * group, float * s_vec3, int find_max)
+{
+	struct box_collision_struct * hull;
+	struct edge_struct * edge;
+	float local_s[3];
+	float best=0.0f;
+	float d;
+	int i_best;
+	int i;
+
+	//the body's position adds the same amount to every edge, only the rotation matters
+	hull = box->hull;
+	HullToLocalDir(box, s_vec3, local_s);
+	i_best = hull->edge_group_members[group->i_first];
+	for(i = 0; i < group->num_members; i++)
+	{
+		edge = hull->edges+hull->edge_group_members[group->i_first+i];
+		d = vDotProduct(local_s, (hull->positions+(edge->i_vertices[0]*3))) + vDotProduct(local_s, (hull->positions+(edge->i_vertices[1]*3)));
+		if(find_max == 1)
+			d = -d;
+		if(i == 0 || d < best)
+		{
+			best = d;
+			i_best = hull->edge_group_members[group->i_first+i];
+		}
+	}
+
+	return i_best;
+}
+
+//stores the separating feature in the cache. returns 1 (found separating axis)
+static int SATEarlyOut(struct d_min_struct * d_min, struct sat_cache_struct * cache, int feature, int index0, int index1)
+{
+	d_min->source = (feature == SAT_FEATURE_EDGES) ? 1 : 0;
+	if(cache != 0)
+	{
+		cache->feature = feature;
+		cache->index[0] = index0;
+		cache->index[1] = index1;
+	}
+	SAT_VERBOSE("separating axis: early out feature=%d d=%f", feature, d_min->d_min);
+
+	return 1;
+}
+
+/*
+Returns the separation of the hulls along the axis of a feature. > 0 means the axis
+separates them. 'axis' gets the axis, pointing into hull A.
+Edge pairs use the cross product of the two edges, oriented away from hull B.
+'support' holds the support vertices of A and B from the last call for warm starting
+hill climbing hulls, it may be 0.
+*/
+static float SATFeatureSeparation(struct box_struct * boxA, struct box_struct * boxB, int feature, int index0, int index1, float * axis, int * support)
+{
+	struct box_collision_struct * hullA;
+	struct box_collision_struct * hullB;
+	float temp_vec[3];
+	float edge_normal[2][3];
+	float neg_axis[3];
+	float min_dot[2];
+	int warm[2]={0, 0};
+	float d;
+
+	hullA = boxA->hull;
+	hullB = boxB->hull;
+
+	if(feature == SAT_FEATURE_FACE_A)
+	{
+		if(index0 < 0 || index0 >= hullA->num_faces)
+			return -1.0f;
+		HullGetFaceNormal(boxA, index0, axis);
+		axis[0] *= -1.0f;
+		axis[1] *= -1.0f;
+		axis[2] *= -1.0f;
+	}
+	else if(feature == SAT_FEATURE_FACE_B)
+	{
+		if(index0 < 0 || index0 >= hullB->num_faces)
+			return -1.0f;
+		HullGetFaceNormal(boxB, index0, axis);
+	}
+	else if(feature == SAT_FEATURE_EDGES)
+	{
+		if(index0 < 0 || index0 >= hullA->num_edges || index1 < 0 || index1 >= hullB->num_edges)
+			return -1.0f;
+		HullGetEdgeNormal(boxA, index0, edge_normal[0]);
+		HullGetEdgeNormal(boxB, index1, edge_normal[1]);
+		vCrossProduct(axis, edge_normal[0], edge_normal[1]);
+		if(vMagnitude(axis) <= 0.001f)
+			return -1.0f; //parallel edges
+		vSubtract(temp_vec, boxA->pos, boxB->pos);
+		if(vDotProduct(axis, temp_vec) < 0.0f)
+		{
+			axis[0] *= -1.0f;
+			axis[1] *= -1.0f;
+			axis[2] *= -1.0f;
+		}
+		vNormalize(axis);
+	}
+	else
+	{
+		return -1.0f;
+	}
+
+	if(support == 0)
+		support = warm;
+	neg_axis[0] = -axis[0];
+	neg_axis[1] = -axis[1];
+	neg_axis[2] = -axis[2];
+	support[0] = HullFindSupport(boxA, axis, support, &(min_dot[0]));
+	support[1] = HullFindSupport(boxB, neg_axis, (support+1), &(min_dot[1]));
+	d = min_dot[0] + min_dot[1];
+
+	return d;
+}
+
+//returns 1 if updated d_min_struct
+static int SATCheckDirection(float * s_vec3, struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min)
+{
+	float d[2];
+	float d_sum;
+	float normal3[3];
+	int r=0;
+
+	//check vertices of hull A
+	//since s points into the shape the support is the vertex with the smallest projection
+	HullFindSupport(boxA, s_vec3, 0, d);
+
+	//check vertices of hull B, so need to negate s
+	memcpy(normal3, s_vec3, 3*sizeof(float));
+	normal3[0] *= -1.0f;
+	normal3[1] *= -1.0f;
+	normal3[2] *= -1.0f;
+	HullFindSupport(boxB, normal3, 0, (d+1));
+	d_sum = d[0] + d[1];
+	//printf("SATCheckDirection: dfinal=%f check HullA s=(%f,%f,%f) d=%f, check HullB s=(%f,%f,%f) d=%f\n", d_sum, s_vec3[0], s_vec3[1], s_vec3[2], d[0], normal3[0], normal3[1], normal3[2], d[1]);
+
+	//if this is the first iteration just set d_min,s_min
+	//for all other iterations perform the check
+	if(d_min->is_initialized == 0)
+	{
+		d_min->d_min = d_sum;
+		d_min->s_min[0] = s_vec3[0];
+		d_min->s_min[1] = s_vec3[1];
+		d_min->s_min[2] = s_vec3[2];
+		r = 1;
+		d_min->is_initialized = 1;
+	}
+	else
+	{
+		if(d_sum > d_min->d_min) 
+		{
+			d_min->d_min = d_sum;
+			d_min->s_min[0] = s_vec3[0];
+			d_min->s_min[1] = s_vec3[1];
+			d_min->s_min[2] = s_vec3[2];
+			r = 1;
+		}
+	}
+
+	return r;
+}
+
+/*
+Writes the arc of one of box's edges in the frame of frame_box's hull, so it can be tested
+against frame_box's arcs as they are stored. That is three rotations per edge of A instead
+of moving every arc of both hulls to world space.
+*/
+static void ArcToHullFrame(struct box_struct * box, struct box_struct * frame_box, struct gauss_arc_struct * arc, struct gauss_arc_struct * frame_arc)
+{
+	memcpy(frame_arc, arc, sizeof(struct gauss_arc_struct));
+	if(box->hull->is_local == 1)
+	{
+		mmTransformVec3(box->orientation, frame_arc->a);
+		mmTransformVec3(box->orientation, frame_arc->b);
+		mmTransformVec3(box->orientation, frame_arc->bxa);
+	}
+	HullToLocalDir(frame_box, frame_arc->a, frame_arc->a);
+	HullToLocalDir(frame_box, frame_arc->b, frame_arc->b);
+	HullToLocalDir(frame_box, frame_arc->bxa, frame_arc->bxa);
+}
+
+/*
+Minkowski face test of edge A against num_arcsB edges of B. Edges A and B build a face of
+the Minkowski difference A - B when the arc of A and the negated arc of B cross on the
+Gauss map. With c, d the negated face normals of B:
+	1. c and d are on opposite sides of the plane of arc A: (c.bxa)*(d.bxa) < 0
+	2. a and b are on opposite sides of the plane of arc B: (a.dxc)*(b.dxc) < 0
+	3. the arcs are in the same hemisphere:                (c.bxa)*(b.dxc) > 0
+dxc of the negated arc is bxa of B, so nothing is computed per pair but dot products.
+Arcs of antipodal faces are half great circles, test 3 can't tell which half so it
+is skipped for them, which only lets extra pairs through.
+Arcs that only touch fail the strict tests. Both edges are then perpendicular to the
+face normal they touch at, so their axis is that face's, which the face checks cover.
+The indices of the pairs that pass are written to i_arcs, returns their count.
+*/
+static int FindMinkowskiFaces(struct gauss_arc_struct * arcA, struct gauss_arc_struct * arcsB, int num_arcsB, int * i_arcs)
+{
+	struct gauss_arc_struct * arcB;
+	float cba;
+	float dba;
+	float adc;
+	float bdc;
+	int is_face;
+	int num_faces=0;
+	int j;
+
+	for(j = 0; j < num_arcsB; j++)
+	{
+		arcB = arcsB+j;
+		cba = -vDotProduct(arcB->a, arcA->bxa);
+		dba = -vDotProduct(arcB->b, arcA->bxa);
+		adc = vDotProduct(arcA->a, arcB->bxa);
+		bdc = vDotProduct(arcA->b, arcB->bxa);
+		is_face = ((cba*dba) < 0.0f) & ((adc*bdc) < 0.0f) & (((cba*bdc) > 0.0f) | arcA->is_antipodal | arcB->is_antipodal);
+		//always write, only advance on a face
+		i_arcs[num_faces] = j;
+		num_faces += is_face;
+	}
+
+	return num_faces;
+}
+
+int CreateEdgeContact(struct d_min_struct * d_min, struct box_struct * boxA, struct box_struct * boxB, struct contact_manifold_struct * contact_manifold)
+{
+	struct edge_struct * edgeA=0;
+	struct edge_struct * edgeB=0;
+	float edgePosA[6];	//2 verts that make the edge
+	float edgePosB[6];
+	float d1343, d4321, d1321, d4343, d2121;
+	float n, d;
+	float edgeBPoint[3];	//closest point on edge B of line btwn edge A to edge B
+	float edgeAPoint[3];	//closest point on edge A of line btwn edge A to edge B
+	float mu_a;
+	float mu_b;
+	float unit[3];
+	float mag;
+
+	edgeA = boxA->hull->edges + d_min->i_edge[0];
+	edgeB = boxB->hull->edges + d_min->i_edge[1];
+
+	//fill in the edges for ease of use
+	//note: d_min.i_hull is not set for edge pair
+	HullGetPosition(boxA, edgeA->i_vertices[0], edgePosA);
+	HullGetPosition(boxA, edgeA->i_vertices[1], (edgePosA+3));
+
+	HullGetPosition(boxB, edgeB->i_vertices[0], edgePosB);
+	HullGetPosition(boxB, edgeB->i_vertices[1], (edgePosB+3));
+
+	d1343 = ((edgePosA[0] - edgePosB[0])*(edgePosB[3] - edgePosB[0])) 
+		+ ((edgePosA[1] - edgePosB[1])*(edgePosB[4] - edgePosB[1])) 
+		+ ((edgePosA[2] - edgePosB[2])*(edgePosB[5] - edgePosB[2]));
+
+	d4321 = ((edgePosB[3] - edgePosB[0])*(edgePosA[3] - edgePosA[0])) 
+		+ ((edgePosB[4] - edgePosB[1])*(edgePosA[4] - edgePosA[1])) 
+		+ ((edgePosB[5] - edgePosB[2])*(edgePosA[5] - edgePosA[2]));
+
+	d1321 = ((edgePosA[0] - edgePosB[0])*(edgePosA[3] - edgePosA[0])) 
+		+ ((edgePosA[1] - edgePosB[1])*(edgePosA[4] - edgePosA[1])) 
+		+ ((edgePosA[2] - edgePosB[2])*(edgePosA[5] - edgePosA[2]));
+
+	d4343 = ((edgePosB[3] - edgePosB[0])*(edgePosB[3] - edgePosB[0])) 
+		+ ((edgePosB[4] - edgePosB[1])*(edgePosB[4] - edgePosB[1])) 
+		+ ((edgePosB[5] - edgePosB[2])*(edgePosB[5] - edgePosB[2]));
+
+	d2121 = ((edgePosA[3] - edgePosA[0])*(edgePosA[3] - edgePosA[0])) 
+		+ ((edgePosA[4] - edgePosA[1])*(edgePosA[4] - edgePosA[1])) 
+		+ ((edgePosA[5] - edgePosA[2])*(edgePosA[5] - edgePosA[2]));
+
+	//denominator of point on edgeB is 0, can't proceed
+	if(fabs(d4343) < 0.0000001f)
+		return 0;
+
+	//denominator of point on edgeA is 0, can't proceed
+	d = (d2121*d4343) - (d4321*d4321);
+	if(fabs(d) < 0.0000001f)
+		return 0;
+	n = (d1343*d4321)-(d1321*d4343);
+	mu_a = n/d;
+
+	n = d1343 + (mu_a*d4321);
+	mu_b = n/d4343;
+
+	edgeAPoint[0] = edgePosA[0] + (mu_a*(edgePosA[3]-edgePosA[0]));
+	edgeAPoint[1] = edgePosA[1] + (mu_a*(edgePosA[4]-edgePosA[1]));
+	edgeAPoint[2] = edgePosA[2] + (mu_a*(edgePosA[5]-edgePosA[2]));
+
+	edgeBPoint[0] = edgePosB[0] + (mu_b*(edgePosB[3] - edgePosB[0]));
+	edgeBPoint[1] = edgePosB[1] + (mu_b*(edgePosB[4] - edgePosB[1]));
+	edgeBPoint[2] = edgePosB[2] + (mu_b*(edgePosB[5] - edgePosB[2]));
+
+	vSubtract(unit, edgePosB, edgePosA);
+	mag = vMagnitude(unit);
+	/*if(mag < 0.0000001f) //TODO: this check doesn't really do anything
+	{
+		contact_info->point[0] = edgeAPoint[0];
+		contact_info->point[1] = edgeAPoint[1];
+		contact_info->point[2] = edgeAPoint[2];
+
+		contact_info->normal[0] = d_min->s_min[0];
+		contact_info->normal[1] = d_min->s_min[1];
+		contact_info->normal[2] = d_min->s_min[2];
+	}*/
+	vNormalize(unit);
+
+	unit[0] *= 0.5f;
+	unit[1] *= 0.5f;
+	unit[2] *= 0.5f;
+
+	contact_manifold->num_contacts = 1;
+	contact_manifold->contacts[0].point[0] = edgeAPoint[0] + (unit[0]*(edgeBPoint[0]-edgeAPoint[0]));
+	contact_manifold->contacts[0].point[1] = edgeAPoint[1] + (unit[1]*(edgeBPoint[1]-edgeAPoint[1]));
+	contact_manifold->contacts[0].point[2] = edgeAPoint[2] + (unit[2]*(edgeBPoint[2]-edgeAPoint[2]));
+
+	contact_manifold->contacts[0].normal[0] = d_min->s_min[0];
+	contact_manifold->contacts[0].normal[1] = d_min->s_min[1];
+	contact_manifold->contacts[0].normal[2] = d_min->s_min[2];
+
+	contact_manifold->contacts[0].penetration = d_min->d_min;
+	contact_manifold->contacts[0].id.feature = SAT_FEATURE_EDGES;
+	contact_manifold->contacts[0].id.index[0] = d_min->i_edge[0];
+	contact_manifold->contacts[0].id.index[1] = d_min->i_edge[1];
+	contact_manifold->contacts[0].id.index[2] = -1;
+	ContactSetLocalPoints(contact_manifold->contacts, boxA, boxB, edgeAPoint, edgeBPoint);
+	contact_manifold->is_complete = 0;
+
+	return 1;
+}
+
+int CreateFaceContact(struct d_min_struct * d_min, 
+	struct box_struct * boxA, 
+	struct box_struct * boxB, 
+	struct contact_manifold_struct * contact_manifold)
+{
+	//d_min struct holds which face is reference face and which is incident face based
+	//on SATCheckDirection().
+	//i_hull[0] -> reference face
+	//i_hull[1] -> incident face
+	float dot;
+	float clip_stack[SAT_CLIP_STACK_VERTS*10];	//the 2 clip lists, contacts and penetrations for faces up to SAT_CLIP_STACK_VERTS
+	int clip_id_stack[SAT_CLIP_STACK_VERTS*3];	//features of the clip list entries
+	float * vertexPosLists[2];		//holds the two vertex lists of clipped vertices.
+	int i_nextList;	//index in vertexPosLists that points to the next list
+	int i_prevList;	//index in vertexPosLists that points to the prev list
+	int list_numVerts[2];			//number of verts in each vertex list.
+	float * p_prevVert;
+	float * p_nextVert;
+	float clipPlaneNormal[3];
+	float clipPlaneEdge[3];
+	float clipPlaneVerts[2][3];
+	float referenceNormal[3];	//world space normal of the reference face
+	float clipDirVec[3];
+	float clip_dist;
+	float temp_vec[3];
+	float * contact_pos_array;
+	float * contact_penetrations;
+	float * p_incidentVert;		//the incident vertex of a contact, before it was moved onto the reference face
+	int * i_incident_verts;		//incident vertex of each entry of the clip lists
+	int * i_clip_edges;			//last reference half edge that moved each entry, or -1
+	int * i_contact_verts;		//entry of the clip lists that made each contact
+	struct box_struct * referenceBox=0;
+	struct box_struct * incidentBox=0;
+	struct box_collision_struct * referenceHull=0;
+	struct box_collision_struct * incidentHull=0;
+	struct face_struct * referenceFace=0;
+	struct face_struct * incidentFace=0;
+	int i;
+	int j;
+	int k;
+	int h;		//half edge
+	int h_next;
+	int i_clip_edge;
+	int num_verts;
+	int i_keep[4];
+	int num_keep;
+
+	if(d_min->i_hull[0] == 0) //reference face is from A
+	{
+		referenceBox = boxA;
+		incidentBox = boxB;
+	}
+	if(d_min->i_hull[0] == 1) //reference face is from B
+	{
+		referenceBox = boxB;
+		incidentBox = boxA;
+	}
+	referenceHull = referenceBox->hull;
+	incidentHull = incidentBox->hull;
+
+	referenceFace = referenceHull->faces + d_min->i_face;
+	HullGetFaceNormal(referenceBox, d_min->i_face, referenceNormal);
+	incidentFace = incidentHull->faces + FindIncidentFace(incidentBox, referenceNormal);
+
+	//setup two lists of vertex positions for clipping. clipping moves vertices
+	//onto the clip planes so the lists never grow past the incident face.
+	num_verts = incidentFace->num_verts;
+	if(num_verts <= SAT_CLIP_STACK_VERTS)
+	{
+		vertexPosLists[0] = clip_stack;
+		i_incident_verts = clip_id_stack;
+	}
+	else
+	{
+		//bigger faces use the scratch InitHullHalfEdges() sized for the hull's largest face
+		if(incidentHull->clip_scratch == 0 || num_verts > incidentHull->max_face_verts)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		vertexPosLists[0] = incidentHull->clip_scratch;
+		i_incident_verts = incidentHull->clip_id_scratch;
+	}
+	vertexPosLists[1] = vertexPosLists[0]+(num_verts*3);
+	contact_pos_array = vertexPosLists[1]+(num_verts*3);
+	contact_penetrations = contact_pos_array+(num_verts*3);
+	i_clip_edges = i_incident_verts+num_verts;
+	i_contact_verts = i_clip_edges+num_verts;
+	list_numVerts[0] = 0;
+	list_numVerts[1] = 0;
+	i_nextList = 1;
+	i_prevList = 0;
+
+	//Setup the vertex list. Add all vertices of the incident face to the prev vertex pos list.
+	//The clipping will place new vertices in the i_nextList
+	i = 0;
+	h = incidentFace->i_half_edge;
+	do
+	{
+		HullGetPosition(incidentBox, incidentHull->half_edges[h].i_vertex, (vertexPosLists[0]+(i*3)));
+		i_incident_verts[i] = incidentHull->half_edges[h].i_vertex;
+		i_clip_edges[i] = -1;
+		i += 1;
+		h = incidentHull->half_edges[h].i_next;
+	} while(h != incidentFace->i_half_edge);
+	list_numVerts[0] = i;
+
+	//loop through each edge of the reference face
+	h = referenceFace->i_half_edge;
+	do
+	{
+		list_numVerts[i_nextList] = 0; //reset the next vertex list.
+
+		//create a clip plane from the current reference face edge.
+		i_clip_edge = h;
+		h_next = referenceHull->half_edges[h].i_next;
+		HullGetPosition(referenceBox, referenceHull->half_edges[h].i_vertex, clipPlaneVerts[0]);
+		HullGetPosition(referenceBox, referenceHull->half_edges[h_next].i_vertex, clipPlaneVerts[1]);
+		h = h_next;
+
+		vSubtract(clipPlaneEdge, clipPlaneVerts[1], clipPlaneVerts[0]);
+		vCrossProduct(clipPlaneNormal, referenceNormal, clipPlaneEdge); //clipPlaneNormal should face inward towards center of ref plane
+		vNormalize(clipPlaneNormal);
+
+		for(j = 0; j < list_numVerts[i_prevList]; j++)
+		{
+			p_prevVert = vertexPosLists[i_prevList]+(j*3);
+			vSubtract(temp_vec, p_prevVert, clipPlaneVerts[0]);
+			dot = vDotProduct(clipPlaneNormal, temp_vec);
+			p_nextVert = vertexPosLists[i_nextList]+(list_numVerts[i_nextList]*3);
+
+			//if the dot product is >= 0 then leave the vertex as is, but if it is
+			//negative, then the vertex is on the side of the clip plane and needs
+			//to be clipped.
+			if(dot >= 0.0f)
+			{
+				p_nextVert[0] = p_prevVert[0];
+				p_nextVert[1] = p_prevVert[1];
+				p_nextVert[2] = p_prevVert[2];
+				list_numVerts[i_nextList] += 1;
+			}
+			else //clip the vertex
+			{
+				clipDirVec[0] = clipPlaneNormal[0];
+				clipDirVec[1] = clipPlaneNormal[1];
+				clipDirVec[2] = clipPlaneNormal[2];
+				clip_dist = fabs(dot);
+				clipDirVec[0] *= clip_dist;
+				clipDirVec[1] *= clip_dist;
+				clipDirVec[2] *= clip_dist;
+
+				vAdd(p_nextVert, p_prevVert, clipDirVec);
+				list_numVerts[i_nextList] += 1;
+				i_clip_edges[j] = i_clip_edge;	//entries never get dropped, so entry j is always incident vertex j
+			}
+		}
+		
+		//advance i_prevList, i_nextList
+		i_prevList = (i_prevList + 1) % 2;
+		i_nextList = (i_nextList + 1) % 2;
+	} while(h != referenceFace->i_half_edge);
+	//now the final list of vertices is in vertexPosLists[i_prevList]
+
+	//now take all contacts and keep the ones below the reference frame
+	list_numVerts[i_nextList] = 0;
+	HullGetPosition(referenceBox, referenceFace->i_vertices[0], clipPlaneVerts[0]); //get a vertex on the reference face.
+	for(i = 0; i < list_numVerts[i_prevList]; i++)
+	{
+		p_prevVert = vertexPosLists[i_prevList] + (i*3); //get the ith vertex from the list
+		p_nextVert = contact_pos_array + (list_numVerts[i_nextList]*3);
+
+		vSubtract(temp_vec, p_prevVert, clipPlaneVerts[0]);
+		dot = vDotProduct(temp_vec, referenceNormal);
+
+		if(dot <= 0.0f) //plane normal vec points out, so look for negative dot-products, these are below the plane
+		{
+			//for vertices below the clip plane move them to reference plane
+			clipDirVec[0] = referenceNormal[0];
+			clipDirVec[1] = referenceNormal[1];
+			clipDirVec[2] = referenceNormal[2];
+			clip_dist = fabs(dot);
+
+			//save the clip_dist in the contact_info_struct as penetration
+			//TODO: Is this the best way to get penetration?
+			contact_penetrations[(list_numVerts[i_nextList])] = clip_dist;
+			i_contact_verts[(list_numVerts[i_nextList])] = i;
+
+			clipDirVec[0] *= clip_dist;
+			clipDirVec[1] *= clip_dist;
+			clipDirVec[2] *= clip_dist;
+			vAdd(p_nextVert, p_prevVert, clipDirVec);
+			
+			list_numVerts[i_nextList] += 1;
+		}
+	}
+	
+	//transfer contact_pos_array to contact_info_struct. fill in new num_contacts too.
+	//faces with more than 4 vertices can leave more contacts than the manifold holds
+	num_keep = ReduceContacts(contact_pos_array, contact_penetrations, list_numVerts[i_nextList], referenceNormal, i_keep);
+	contact_manifold->num_contacts = num_keep;
+	contact_manifold->is_complete = (num_keep == num_verts) ? 1 : 0;
+	for(i = 0; i < num_keep; i++)
+	{
+		j = i_keep[i];
+		k = i_contact_verts[j];
+		contact_manifold->contacts[i].id.feature = (d_min->i_hull[0] == 0) ? SAT_FEATURE_FACE_A : SAT_FEATURE_FACE_B;
+		contact_manifold->contacts[i].id.index[0] = d_min->i_face;
+		contact_manifold->contacts[i].id.index[1] = i_incident_verts[k];
+		contact_manifold->contacts[i].id.index[2] = i_clip_edges[k];
+		contact_manifold->contacts[i].point[0] = contact_pos_array[(j*3)];
+		contact_manifold->contacts[i].point[1] = contact_pos_array[(j*3)+1];
+		contact_manifold->contacts[i].point[2] = contact_pos_array[(j*3)+2];
+		contact_manifold->contacts[i].normal[0] = d_min->s_min[0];
+		contact_manifold->contacts[i].normal[1] = d_min->s_min[1];
+		contact_manifold->contacts[i].normal[2] = d_min->s_min[2];
+		contact_manifold->contacts[i].penetration = contact_penetrations[j];
+
+		//the contact is on the reference face. the point on the incident body is the side-clipped
+		//incident vertex, before it was projected onto the reference face
+		p_incidentVert = vertexPosLists[i_prevList]+(k*3);
+		if(referenceBox == boxA)
+			ContactSetLocalPoints(contact_manifold->contacts+i, boxA, boxB, contact_pos_array+(j*3), p_incidentVert);
+		else
+			ContactSetLocalPoints(contact_manifold->contacts+i, boxA, boxB, p_incidentVert, contact_pos_array+(j*3));
+	}
+
+	//perform a check for contacts that are too close together
+	
+	return 1;
+}
+
+/*
+Finds the face of the incident hull most anti-parallel to the reference normal. That
+face is almost always one of the faces around the incident hull's deepest vertex along
+the normal. The best of those is then moved to a neighbor face while one is better, so
+only a few faces are checked instead of every face of the hull.
+*/
+static int FindIncidentFace(struct box_struct * incidentBox, float * referenceNormal)
+{
+	struct box_collision_struct * hull;
+	struct half_edge_struct * half_edges;
+	float localNormal[3];	//referenceNormal in the frame of the incident hull
+	float smallest_dot=0.0f;
+	float dot;
+	float min_dot;
+	int i_best=-1;
+	int i_face;
+	int i_vertex;
+	int h_start;
+	int h;
+	int i;
+
+	hull = incidentBox->hull;
+	half_edges = hull->half_edges;
+	HullToLocalDir(incidentBox, referenceNormal, localNormal);
+	i_vertex = HullFindSupport(incidentBox, referenceNormal, 0, &min_dot);
+	h_start = hull->vertex_half_edge[i_vertex];
+	if(h_start == -1)
+	{
+		//the vertex isn't on any face, look at all of them
+		for(i = 0; i < hull->num_faces; i++)
+		{
+			dot = vDotProduct(localNormal, hull->faces[i].normal);
+			if(i_best == -1 || dot < smallest_dot)
+			{
+				smallest_dot = dot;
+				i_best = i;
+			}
+		}
+		return i_best;
+	}
+
+	//walk the half edges leaving the vertex, on a tie keep the lower face like a scan would
+	h = h_start;
+	do
+	{
+		i = half_edges[h].i_face;
+		dot = vDotProduct(localNormal, hull->faces[i].normal);
+		if(i_best == -1 || dot < smallest_dot || (dot == smallest_dot && i < i_best))
+		{
+			smallest_dot = dot;
+			i_best = i;
+		}
+		h = half_edges[half_edges[h].i_twin].i_next;
+	} while(h != h_start);
+
+	do
+	{
+		i_face = i_best;
+		h_start = hull->faces[i_face].i_half_edge;
+		h = h_start;
+		do
+		{
+			i = half_edges[half_edges[h].i_twin].i_face;
+			dot = vDotProduct(localNormal, hull->faces[i].normal);
+			if(dot < smallest_dot)
+			{
+				smallest_dot = dot;
+				i_best = i;
+			}
+			h = half_edges[h].i_next;
+		} while(h != h_start);
+	} while(i_best != i_face);
+
+	return i_best;
+}
+
+/*
+Picks up to 4 of the num_points clipped contacts, all of them if there are 4 or less.
+Otherwise it keeps the deepest one, the one farthest from it, and the two that
+add the most area on either side of the line between them.
+returns the number of contacts in i_keep.
+*/
+static int ReduceContacts(float * points, float * penetrations, int num_points, float * normal, int * i_keep)
+{
+	float d[3];
+	float c[3];
+	float temp_cross[3];
+	float best;
+	float area;
+	int i;
+	int k;
+
+	if(num_points <= 4)
+	{
+		for(i = 0; i < num_points; i++)
+		{
+			i_keep[i] = i;
+		}
+		return num_points;
+	}
+
+	i_keep[0] = 0;
+	for(i = 1; i < num_points; i++)
+	{
+		if(penetrations[i] > penetrations[i_keep[0]])
+			i_keep[0] = i;
+	}
+	best = -1.0f;
+	for(i = 0; i < num_points; i++)
+	{
+		vSubtract(d, (points+(i*3)), (points+(i_keep[0]*3)));
+		if(vDotProduct(d, d) > best)
+		{
+			best = vDotProduct(d, d);
+			i_keep[1] = i;
+		}
+	}
+	//signed area of the triangle with the line, largest on each side
+	for(k = 2; k < 4; k++)
+	{
+		best = 0.0f;
+		i_keep[k] = -1;
+		for(i = 0; i < num_points; i++)
+		{
+			vSubtract(d, (points+(i_keep[1]*3)), (points+(i_keep[0]*3)));
+			vSubtract(c, (points+(i*3)), (points+(i_keep[0]*3)));
+			vCrossProduct(temp_cross, d, c);
+			area = vDotProduct(temp_cross, normal);
+			if(k == 3)
+				area = -area;
+			if(area > best)
+			{
+				best = area;
+				i_keep[k] = i;
+			}
+		}
+	}
+	//a side with nothing on it leaves a hole, close it up
+	k = 2;
+	for(i = 2; i < 4; i++)
+	{
+		if(i_keep[i] != -1)
+		{
+			i_keep[k] = i_keep[i];
+			k += 1;
+		}
+	}
+
+	return k;
+}
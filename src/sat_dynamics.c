@@ -0,0 +1,461 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+#include "sat_trace.h"
+
+static void ApplyContactImpulse(struct box_struct * boxA, struct box_struct * boxB, struct contact_info_struct * contact, float impulse_mag, int is_b_ground);
+static void ApplySplitImpulse(struct box_struct * pbox, struct contact_info_struct * contact, float impulse_mag);
+
+struct solver_config_struct g_solver_config =
+{
+	10,		//num_iterations
+	2,		//num_sweeps. with the contacts of each manifold settled first, 2 keep stacks as still as the pair solver
+	1,		//warm_start
+	0.0f,	//residual_tolerance
+	1,		//global_solver
+	1,		//graph_coloring
+	0.12f,	//bias_factor. the impulses reach further down a stack than solving pair by pair, pair_bias_factor pops stacks apart
+	0.6f,	//pair_bias_factor. 0.01/dt with the old 1/60 step
+	0.0001f,	//bias_margin
+	1,		//lane_solver
+	0,		//block_solver
+	0,		//split_impulse
+	1,		//split_iterations. each sweep settles the contacts of a manifold like the velocity sweeps do
+	0.2f,	//split_bias_factor
+	0.0001f	//split_margin
+};
+
+struct solver_stats_struct g_solver_stats;
+
+int InitObjBox(struct box_struct * pbox, float x, float y, float z)
+{
+	float momentOfInertia[9];
+	float inertiaTerm;
+
+	memset(pbox, 0, sizeof(struct box_struct));
+
+	pbox->pos[0] = x;
+	pbox->pos[1] = y;
+	pbox->pos[2] = z;
+
+	pbox->orientationQ[0] = 0.0f; //x
+	pbox->orientationQ[1] = 0.0f; //y
+	pbox->orientationQ[2] = 0.0f; //z
+	pbox->orientationQ[3] = 1.0f; //w
+	qConvertToMat3(pbox->orientationQ, pbox->orientation);
+
+	pbox->mass = 1.0f;
+
+	inertiaTerm = (1.0f/12.0f)*pbox->mass*(1.0f + 1.0f);	//assume box width, height both == 1
+	pbox->imomentOfInertia[0] = 1.0f/inertiaTerm;
+	pbox->imomentOfInertia[4] = 1.0f/inertiaTerm;
+	pbox->imomentOfInertia[8] = 1.0f/inertiaTerm;
+
+	//TODO: Remove this debug. Check rotation
+	//pbox->angularMomentum[1] = 0.0001f;
+
+	return 1;//success
+}
+
+/*
+borrow the box_struct, since the collision functions pull out some
+velocity information from both objects even if one of them is ground.
+*/
+int InitObjPlane(struct box_struct * plane)
+{
+	memset(plane, 0, sizeof(struct box_struct));
+
+	plane->orientationQ[0] = 0.0f; //x
+	plane->orientationQ[1] = 0.0f; //y
+	plane->orientationQ[2] = 0.0f; //z
+	plane->orientationQ[3] = 1.0f; //w
+	qConvertToMat3(plane->orientationQ, plane->orientation);
+
+	return 1; //succes
+}
+
+//moves the box by its new velocities for 'dt' seconds
+void UpdateBoxSimulation(struct box_collision_struct * base_hull, struct box_struct * pbox, float dt)
+{
+
+	//CalculateBoxVelocity(pbox, newLinearVel, newAngularMomentum, newAngularVelQ);
+	//Idea is for CalculateBoxVelocity() to be called earlier and then this
+	//func will update position/orientation
+
+	UpdateBoxVelocity(pbox);
+
+	//the pseudo velocities of the split impulse move the box this step but aren't kept
+	if(g_solver_config.split_impulse == 1)
+	{
+		vAdd(pbox->newLinearVel, pbox->newLinearVel, pbox->splitLinearVel);
+		vAdd(pbox->newAngularVelQ, pbox->newAngularVelQ, pbox->splitAngularVel);
+		memset(pbox->splitLinearVel, 0, 3*sizeof(float));
+		memset(pbox->splitAngularVel, 0, 3*sizeof(float));
+	}
+
+	//update linear position
+	pbox->pos[0] += pbox->newLinearVel[0]*dt;
+	pbox->pos[1] += pbox->newLinearVel[1]*dt;
+	pbox->pos[2] += pbox->newLinearVel[2]*dt;
+
+	//Calculate new orientation
+	//q_i+1 = q + (h/2)*w*q		;note: here w is a quaternion q(0,w)
+	qMultiply(pbox->newAngularVelQ, pbox->newAngularVelQ, pbox->orientationQ);
+	pbox->newAngularVelQ[0] *= 0.5f*dt;
+	pbox->newAngularVelQ[1] *= 0.5f*dt;
+	pbox->newAngularVelQ[2] *= 0.5f*dt;
+	pbox->newAngularVelQ[3] *= 0.5f*dt;
+	qAdd(pbox->newAngularVelQ, pbox->orientationQ, pbox->newAngularVelQ);
+	//Re-normalize the quaternion
+	qNormalize(pbox->newAngularVelQ);
+
+	pbox->orientationQ[0] = pbox->newAngularVelQ[0];
+	pbox->orientationQ[1] = pbox->newAngularVelQ[1];
+	pbox->orientationQ[2] = pbox->newAngularVelQ[2];
+	pbox->orientationQ[3] = pbox->newAngularVelQ[3];
+	qConvertToMat3(pbox->newAngularVelQ, pbox->orientation);
+
+	//update the physics hull:
+	UpdateHull(base_hull, pbox);
+}
+
+void UpdateBoxVelocity(struct box_struct * pbox)
+{
+	pbox->linearVel[0] = pbox->newLinearVel[0];
+	pbox->linearVel[1] = pbox->newLinearVel[1];
+	pbox->linearVel[2] = pbox->newLinearVel[2];
+
+	pbox->angularVel[0] = pbox->newAngularVelQ[0];
+	pbox->angularVel[1] = pbox->newAngularVelQ[1];
+	pbox->angularVel[2] = pbox->newAngularVelQ[2];
+
+	pbox->angularMomentum[0] = pbox->newAngularMomentum[0];
+	pbox->angularMomentum[1] = pbox->newAngularMomentum[1];
+	pbox->angularMomentum[2] = pbox->newAngularMomentum[2];
+}
+
+//This function updates in box_struct:
+//	newLinearVel
+//	newAngularMomentum
+//	newAngularVelQ
+//the torques and forces act for 'dt' seconds. impulses are passed with dt = 1
+void CalculateNewBoxVelocity(struct box_struct * pbox, 
+		float * sumTorques,		//in
+		float * sumForces,		//in
+		float dt)
+{
+	float torque_impulse[3];
+	float iorient[9];
+	float imomentOfInertiaWorld[9];
+
+	//Prepare to calculate angular velocity
+	//L_i+1 = L_i + h*T
+	torque_impulse[0] = sumTorques[0]*dt;
+	torque_impulse[1] = sumTorques[1]*dt;
+	torque_impulse[2] = sumTorques[2]*dt;
+	vAdd(pbox->newAngularMomentum, pbox->angularMomentum, torque_impulse);
+
+	//Transform InverseMomentOfInertia from local to world coordinates
+	//I_i^-1 = (R_i)*(I_0^-1)*(R_i^-1)
+	memcpy(iorient, pbox->orientation, (9*sizeof(float)));
+	mmTranspose3x3(iorient);
+	memcpy(imomentOfInertiaWorld, pbox->imomentOfInertia, (9*sizeof(float)));
+	mmMultiplyMatrix3x3(imomentOfInertiaWorld, iorient, imomentOfInertiaWorld);
+	mmMultiplyMatrix3x3(pbox->orientation, imomentOfInertiaWorld, imomentOfInertiaWorld);
+
+	//Calculate angular velocity for real
+	//w_i+1 = (I_i^-1)*(L_i+1)
+	pbox->newAngularVelQ[0] = pbox->newAngularMomentum[0];
+	pbox->newAngularVelQ[1] = pbox->newAngularMomentum[1];
+	pbox->newAngularVelQ[2] = pbox->newAngularMomentum[2];
+	mmTransformVec3(imomentOfInertiaWorld, pbox->newAngularVelQ);
+	pbox->newAngularVelQ[3] = 0.0f;
+
+	//Calculate new velocity
+	pbox->newLinearVel[0] = pbox->linearVel[0] + ((sumForces[0]*dt)/pbox->mass);
+	pbox->newLinearVel[1] = pbox->linearVel[1] + ((sumForces[1]*dt)/pbox->mass);
+	pbox->newLinearVel[2] = pbox->linearVel[2] + ((sumForces[2]*dt)/pbox->mass);	
+}
+
+void ApplyCollisionImpulses(struct box_struct * boxA, struct box_struct * boxB, struct contact_info_struct * contacts, int num_contacts, int is_b_ground, float dt)
+{
+	//TODO: Need to find out if this is bad Assume: Max of 4 contacts. This might be dumb?
+	float impulse_k[4];
+	float impulse[4];
+	float old_impulse[4];
+	float split_impulse[4];
+	float cur_impulse_mag;
+	float delta_linear_vel[3];
+	float * r[2]; //0 = boxA r, 1 = box B r. where r is vec from box CG to contact point.
+	float r_boxA[3] = {0.0f, 0.0f, 0.0f};
+	float r_boxB[3] = {0.0f, 0.0f, 0.0f};
+	float temp_vec[3];
+	float cross_vec[3];
+	float sum_vec[3];
+	float vel_bias = 0.0f;
+	float residual = 0.0f;	//largest impulse change of an iteration
+	int i;
+	int j;
+	int k;
+
+	memset(impulse, 0, 4*sizeof(float));
+	memset(old_impulse, 0, 4*sizeof(float));
+	memset(split_impulse, 0, 4*sizeof(float));
+
+	//calculate k_constant for Impulse from contact normal. This is constant throughout iterations.
+	r[0] = r_boxA;
+	r[1] = r_boxB;
+	for(i = 0; i < num_contacts; i++)
+	{
+		//k_n = (1/m_1) + (1/m_2) + (( (I_1^-1*(r1 cross n) cross r1) + I_2^-1(r2 cross n) cross r2) dot n)
+
+		//I_1^-1*(r1 cross n) cross r1
+		vSubtract(r[0], contacts[i].point, boxA->pos);
+		vCrossProduct(cross_vec, r[0], contacts[i].normal);
+		vCrossProduct(temp_vec, cross_vec, r[0]);
+		mmTransformVec3(boxA->imomentOfInertia, temp_vec); //TODO: Need to fix this. box->imomentOfInertia is in model space, but needs to be in world space.
+		sum_vec[0] = temp_vec[0];	//sum_vec will hold the sum of the two terms with I_1^-1 and I_2^-1
+		sum_vec[1] = temp_vec[1];
+		sum_vec[2] = temp_vec[2];
+		
+		//I_2^-1*(r2 cross n) cross r2
+		if(is_b_ground == 0)
+		{
+			vSubtract(r[1], contacts[i].point, boxB->pos);
+			vCrossProduct(cross_vec, r[1], contacts[i].normal);
+			vCrossProduct(temp_vec, cross_vec, r[1]);
+			mmTransformVec3(boxB->imomentOfInertia, temp_vec);
+			sum_vec[0] += temp_vec[0];
+			sum_vec[1] += temp_vec[1];
+			sum_vec[2] += temp_vec[2];
+		}
+
+		impulse_k[i] = (1/boxA->mass) + vDotProduct(sum_vec, contacts[i].normal);
+
+		//If b is ground then skip calculating its mass
+		if(is_b_ground == 0)
+		{
+			impulse_k[i] += (1/boxB->mass);
+		}
+	}
+
+	//warm start: apply the impulses the contacts ended the last step with, the
+	//iterations below then only have to correct them.
+	if(g_solver_config.warm_start == 1)
+	{
+		for(j = 0; j < num_contacts; j++)
+		{
+			impulse[j] = contacts[j].normal_impulse;
+			ApplyContactImpulse(boxA, boxB, (contacts+j), impulse[j], is_b_ground);
+		}
+	}
+
+	SAT_VERBOSE("box0 init linearVel=(%f,%f,%f) angularVel=(%f,%f,%f)", boxA->linearVel[0], boxA->linearVel[1], boxA->linearVel[2], boxA->angularVel[0], boxA->angularVel[1], boxA->angularVel[2]);
+	for(k = 0; k < g_solver_config.num_iterations; k++)
+	{
+		//printf("impulse round %d:\n", k);
+		residual = 0.0f;
+		for(j = 0; j < num_contacts; j++)
+		{
+			//dV = v_2 + (w_2 cross r_2) - v_1 - (w_1 cross r_1)
+			//TODO: Shouldn't we be using newLinearVel here? otherwise how does linearVel
+			//get updated?
+			vSubtract(r[0], contacts[j].point, boxA->pos);
+			vCrossProduct(cross_vec, boxA->angularVel, r[0]);
+			vAdd(delta_linear_vel, boxA->linearVel, cross_vec);
+			vSubtract(r[1], contacts[j].point, boxB->pos);
+			vCrossProduct(cross_vec, boxB->angularVel, r[1]);
+			vSubtract(delta_linear_vel, delta_linear_vel, boxB->linearVel);
+			vSubtract(delta_linear_vel, delta_linear_vel, cross_vec);
+
+			//same calls as above just using newLinearVel, this doesn't work right.
+			/*vCrossProduct(cross_vec, boxA->newAngularVelQ, r[0]);
+			vAdd(delta_linear_vel, boxA->newLinearVel, cross_vec);
+			vCrossProduct(cross_vec, boxB->newAngularVelQ, r[1]);
+			vSubtract(delta_linear_vel, delta_linear_vel, boxB->newLinearVel);
+			vSubtract(delta_linear_vel, delta_linear_vel, cross_vec);*/
+
+			//max[ (-dV dot n + v_bias)/k_n , 0]. the split impulse pushes the penetration out below instead
+			vel_bias = 0.0f;
+			if(g_solver_config.split_impulse == 0)
+				vel_bias = CalcBaumgarteBias(contacts[j].penetration, g_solver_config.pair_bias_factor, dt);
+			cur_impulse_mag = (((-1.0f*vDotProduct(delta_linear_vel, contacts[j].normal)) + vel_bias)/impulse_k[j]);
+	
+			//clamp the accumulated impulse
+			old_impulse[j] = impulse[j];
+			impulse[j] += cur_impulse_mag;
+			if(impulse[j] < 0.0f)	//clamp 0
+				impulse[j] = 0.0f;
+			if(fabs(impulse[j] - old_impulse[j]) > residual)
+				residual = fabs(impulse[j] - old_impulse[j]);
+
+			SAT_VERBOSE("\tcontact=%d impulse=%f contactpos=(%f,%f,%f)", j, (impulse[j]-old_impulse[j]), contacts[j].point[0], contacts[j].point[1], contacts[j].point[2]);
+
+			ApplyContactImpulse(boxA, boxB, (contacts+j), (impulse[j] - old_impulse[j]), is_b_ground);
+		}
+		SAT_VERBOSE("\tboxA endLinearVel=(%f,%f,%f) endAngularVel=(%f,%f,%f)", boxA->newLinearVel[0], boxA->newLinearVel[1], boxA->newLinearVel[2], boxA->newAngularVelQ[0], boxA->newAngularVelQ[1], boxA->newAngularVelQ[2]);
+
+		if(g_solver_config.residual_tolerance > 0.0f && residual <= g_solver_config.residual_tolerance)
+		{
+			g_solver_stats.num_converged += 1;
+			k += 1;
+			break;
+		}
+	}
+	g_solver_stats.num_solves += 1;
+	g_solver_stats.num_iterations += k;
+	if(residual > g_solver_stats.max_residual)
+		g_solver_stats.max_residual = residual;
+
+	//keep the impulses for the next step
+	for(j = 0; j < num_contacts; j++)
+	{
+		contacts[j].normal_impulse = impulse[j];
+	}
+
+	//the pseudo velocities of the split impulse start from zero every step and only move the boxes
+	if(g_solver_config.split_impulse == 1)
+	{
+		for(k = 0; k < g_solver_config.num_iterations; k++)
+		{
+			for(j = 0; j < num_contacts; j++)
+			{
+				vSubtract(r[0], contacts[j].point, boxA->pos);
+				vCrossProduct(cross_vec, boxA->splitAngularVel, r[0]);
+				vAdd(delta_linear_vel, boxA->splitLinearVel, cross_vec);
+				if(is_b_ground == 0)
+				{
+					vSubtract(r[1], contacts[j].point, boxB->pos);
+					vCrossProduct(cross_vec, boxB->splitAngularVel, r[1]);
+					vSubtract(delta_linear_vel, delta_linear_vel, boxB->splitLinearVel);
+					vSubtract(delta_linear_vel, delta_linear_vel, cross_vec);
+				}
+
+				cur_impulse_mag = (((-1.0f*vDotProduct(delta_linear_vel, contacts[j].normal)) + CalcSplitBias(contacts[j].penetration, dt))/impulse_k[j]);
+				old_impulse[j] = split_impulse[j];
+				split_impulse[j] += cur_impulse_mag;
+				if(split_impulse[j] < 0.0f)
+					split_impulse[j] = 0.0f;
+
+				ApplySplitImpulse(boxA, (contacts+j), (split_impulse[j] - old_impulse[j]));
+				if(is_b_ground == 0)
+					ApplySplitImpulse(boxB, (contacts+j), (old_impulse[j] - split_impulse[j]));
+			}
+		}
+	}
+
+	//print out the final impulses. impulse[j] should have the sum of all impulses from each iteration.
+	SAT_DEBUG("final impulses: num_contacts=%d %f %f %f %f iterations=%d residual=%g", num_contacts, impulse[0], impulse[1], impulse[2], impulse[3], k, residual);
+
+	//CalculateBoxVelocity() now has updated newLinearVel, newAngularMomentum, newAngularVelQ
+	//ready to apply for position
+}
+
+//applies an impulse of magnitude 'impulse_mag' along the contact normal to boxA and the opposite one to boxB
+static void ApplyContactImpulse(struct box_struct * boxA, struct box_struct * boxB, struct contact_info_struct * contact, float impulse_mag, int is_b_ground)
+{
+	float impulse_vec[3];
+	float temp_vec[3];
+	float cross_vec[3];
+
+	//apply impulse for box A
+	impulse_vec[0] = contact->normal[0];
+	impulse_vec[1] = contact->normal[1];
+	impulse_vec[2] = contact->normal[2];
+	impulse_vec[0] *= impulse_mag;
+	impulse_vec[1] *= impulse_mag;
+	impulse_vec[2] *= impulse_mag;
+
+	vSubtract(temp_vec, contact->point, boxA->pos); 	//calculate R
+	vCrossProduct(cross_vec, temp_vec, impulse_vec);	//calculate torque
+
+	//TODO: Remove this but try to recalc velocity after every impulse
+	CalculateNewBoxVelocity(boxA, cross_vec, impulse_vec, 1.0f);
+	UpdateBoxVelocity(boxA);
+
+	//apply impulse for box B
+	if(is_b_ground == 0) //only add force if B is a regular object. If B is ground treat it as infinite mass.
+	{
+		impulse_vec[0] = -1.0f*contact->normal[0];
+		impulse_vec[1] = -1.0f*contact->normal[1];
+		impulse_vec[2] = -1.0f*contact->normal[2];
+		impulse_vec[0] *= impulse_mag;
+		impulse_vec[1] *= impulse_mag;
+		impulse_vec[2] *= impulse_mag;
+
+		vSubtract(temp_vec, contact->point, boxB->pos);
+		vCrossProduct(cross_vec, temp_vec, impulse_vec);
+
+		CalculateNewBoxVelocity(boxB, cross_vec, impulse_vec, 1.0f);
+		UpdateBoxVelocity(boxB);
+	}
+}
+
+//adds an impulse of magnitude 'impulse_mag' along the contact normal to the pseudo velocities of 'pbox'
+static void ApplySplitImpulse(struct box_struct * pbox, struct contact_info_struct * contact, float impulse_mag)
+{
+	float impulse_vec[3];
+	float temp_vec[3];
+	float cross_vec[3];
+	float iorient[9];
+	float imomentOfInertiaWorld[9];
+
+	impulse_vec[0] = contact->normal[0]*impulse_mag;
+	impulse_vec[1] = contact->normal[1]*impulse_mag;
+	impulse_vec[2] = contact->normal[2]*impulse_mag;
+
+	vSubtract(temp_vec, contact->point, pbox->pos);
+	vCrossProduct(cross_vec, temp_vec, impulse_vec);
+
+	//I_i^-1 = (R_i)*(I_0^-1)*(R_i^-1)
+	memcpy(iorient, pbox->orientation, (9*sizeof(float)));
+	mmTranspose3x3(iorient);
+	memcpy(imomentOfInertiaWorld, pbox->imomentOfInertia, (9*sizeof(float)));
+	mmMultiplyMatrix3x3(imomentOfInertiaWorld, iorient, imomentOfInertiaWorld);
+	mmMultiplyMatrix3x3(pbox->orientation, imomentOfInertiaWorld, imomentOfInertiaWorld);
+	mmTransformVec3(imomentOfInertiaWorld, cross_vec);
+
+	pbox->splitLinearVel[0] += impulse_vec[0]/pbox->mass;
+	pbox->splitLinearVel[1] += impulse_vec[1]/pbox->mass;
+	pbox->splitLinearVel[2] += impulse_vec[2]/pbox->mass;
+	vAdd(pbox->splitAngularVel, pbox->splitAngularVel, cross_vec);
+}
+
+//'dt' is the step the bias velocity has to push out the penetration in
+float CalcBaumgarteBias(float penetration, float bias_factor, float dt)
+{
+	float k_bias_factor = bias_factor;
+	float k_bias_margin = g_solver_config.bias_margin;
+	float bias;
+	float dist;
+
+	//v_bias = k_bias_factor/dt * max(0, penetration - k_bias_margin)
+	penetration = fabs(penetration);
+	dist = penetration - k_bias_margin;
+	if(dist < 0.0f)
+		dist = 0.0f;
+	bias = (k_bias_factor*dist)/dt;
+
+	return bias;
+}
+
+/*
+Pseudo velocity of the split impulse. Unlike the Baumgarte bias it only moves the
+positions, so it can push out a larger part of the penetration without adding energy.
+*/
+float CalcSplitBias(float penetration, float dt)
+{
+	float dist;
+
+	//v_split = k_split_factor/dt * max(0, penetration - k_split_margin)
+	penetration = fabs(penetration);
+	dist = penetration - g_solver_config.split_margin;
+	if(dist < 0.0f)
+		dist = 0.0f;
+
+	return (g_solver_config.split_bias_factor*dist)/dt;
+}
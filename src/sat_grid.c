@@ -0,0 +1,487 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sat.h"
+
+/*
+Uniform spatial hash grid broadphase.
+Every step:
+	1. aabb and cell range of each body				(parallel over bodies)
+	2. prefix sum of cell counts					(serial)
+	3. write one (cell hash, body) entry per cell	(parallel over bodies)
+	4. sort entries by (hash, body)					(parallel chunk sort + merge passes)
+	5. pairs from bodies that share a cell			(parallel over runs of equal hash)
+	6. concatenate, sort and remove duplicates		(serial)
+A pair is only emitted from the cell holding the min corner of the intersection of the
+two aabbs, so it is normally found once. Hash collisions can still produce duplicates,
+those are removed in step 6. Since the final list is sorted, the output doesn't depend
+on the number of threads or how the tasks were scheduled.
+*/
+
+static void GridAabbJob(void * user, int i_task);
+static void GridFillJob(void * user, int i_task);
+static void GridSortJob(void * user, int i_task);
+static void GridMergeJob(void * user, int i_task);
+static void GridPairJob(void * user, int i_task);
+static int GridResize(struct grid_struct * grid, int num_bodies);
+static int GridReserveEntries(struct grid_struct * grid, int num_entries);
+static void GridCellRange(struct grid_struct * grid, struct aabb_struct * aabb, int * cell_min, int * cell_max);
+static unsigned int GridHashCell(int ix, int iy, int iz);
+static int CompareGridEntries(const void * a, const void * b);
+
+void GridInit(struct grid_struct * grid, float cell_size, struct thread_pool_struct * pool)
+{
+	memset(grid, 0, sizeof(struct grid_struct));
+	grid->cell_size = cell_size;
+	grid->pool = pool;
+}
+
+void GridFree(struct grid_struct * grid)
+{
+	int i;
+
+	free(grid->aabbs);
+	free(grid->cell_counts);
+	free(grid->cell_offsets);
+	free(grid->large_bodies);
+	free(grid->entries);
+	free(grid->temp_entries);
+	free(grid->task_ranges);
+	if(grid->task_pairs != 0)
+	{
+		for(i = 0; i < grid->num_tasks; i++)
+		{
+			free(grid->task_pairs[i].pairs);
+		}
+		free(grid->task_pairs);
+	}
+	free(grid->pairs);
+	memset(grid, 0, sizeof(struct grid_struct));
+}
+
+/*
+Fills grid->pairs with the sorted pairs of bodies whose world aabbs overlap.
+returns 0 on failure.
+*/
+int GridUpdate(struct grid_struct * grid, struct box_struct ** bodies, int num_bodies)
+{
+	struct grid_entry_struct * swap_entries;
+	int num_entries;
+	int num_merges;
+	int i_start;
+	int i_end;
+	int i;
+	int j;
+	int t;
+	int r;
+
+	if(num_bodies > grid->max_bodies || grid->task_pairs == 0)
+	{
+		r = GridResize(grid, num_bodies);
+		if(r == 0)
+			return 0;
+	}
+	grid->bodies = bodies;
+	grid->num_bodies = num_bodies;
+
+	//1. aabbs and # of cells touched by each body
+	ThreadPoolRun(grid->pool, GridAabbJob, grid, grid->num_tasks);
+
+	//2. prefix sum. large bodies don't go in the grid.
+	num_entries = 0;
+	grid->num_large = 0;
+	for(i = 0; i < num_bodies; i++)
+	{
+		grid->cell_offsets[i] = num_entries;
+		if(grid->cell_counts[i] < 0)
+		{
+			grid->large_bodies[grid->num_large] = i;
+			grid->num_large += 1;
+		}
+		else
+		{
+			num_entries += grid->cell_counts[i];
+		}
+	}
+	r = GridReserveEntries(grid, num_entries);
+	if(r == 0)
+		return 0;
+	grid->num_entries = num_entries;
+
+	//3. one entry per cell
+	ThreadPoolRun(grid->pool, GridFillJob, grid, grid->num_tasks);
+
+	//4. sort each chunk, then merge neighbouring chunks until there is one run
+	ThreadPoolRun(grid->pool, GridSortJob, grid, grid->num_tasks);
+	for(grid->merge_width = 1; grid->merge_width < grid->num_tasks; grid->merge_width *= 2)
+	{
+		num_merges = (grid->num_tasks + (2*grid->merge_width) - 1)/(2*grid->merge_width);
+		ThreadPoolRun(grid->pool, GridMergeJob, grid, num_merges);
+		swap_entries = grid->entries;
+		grid->entries = grid->temp_entries;
+		grid->temp_entries = swap_entries;
+	}
+
+	//5. split the entries between tasks without splitting a run of equal hashes
+	grid->task_ranges[0] = 0;
+	for(t = 1; t < grid->num_tasks; t++)
+	{
+		GetTaskRange(num_entries, grid->num_tasks, t, &i_start, &i_end);
+		if(i_start < grid->task_ranges[t-1])
+			i_start = grid->task_ranges[t-1];
+		while(i_start > 0 && i_start < num_entries && grid->entries[i_start].hash == grid->entries[i_start-1].hash)
+		{
+			i_start += 1;
+		}
+		grid->task_ranges[t] = i_start;
+	}
+	grid->task_ranges[grid->num_tasks] = num_entries;
+	ThreadPoolRun(grid->pool, GridPairJob, grid, grid->num_tasks);
+
+	//6. gather the task outputs
+	grid->num_pairs = 0;
+	for(t = 0; t < grid->num_tasks; t++)
+	{
+		if(grid->task_pairs[t].is_failed == 1)
+			return 0;
+		for(i = 0; i < grid->task_pairs[t].num_pairs; i++)
+		{
+			r = AddBroadphasePair(&(grid->pairs), &(grid->num_pairs), &(grid->max_pairs),
+				grid->task_pairs[t].pairs[i].i_body[0], grid->task_pairs[t].pairs[i].i_body[1]);
+			if(r == 0)
+				return 0;
+		}
+	}
+	SortBroadphasePairs(grid->pairs, grid->num_pairs);
+	j = 0;
+	for(i = 0; i < grid->num_pairs; i++)
+	{
+		if(j > 0 && grid->pairs[j-1].i_body[0] == grid->pairs[i].i_body[0] && grid->pairs[j-1].i_body[1] == grid->pairs[i].i_body[1])
+			continue;
+		grid->pairs[j] = grid->pairs[i];
+		j += 1;
+	}
+	grid->num_pairs = j;
+
+	return 1;
+}
+
+static void GridAabbJob(void * user, int i_task)
+{
+	struct grid_struct * grid;
+	int cell_min[3];
+	int cell_max[3];
+	int count;
+	int i_start;
+	int i_end;
+	int i;
+
+	grid = (struct grid_struct*)user;
+	GetTaskRange(grid->num_bodies, grid->num_tasks, i_task, &i_start, &i_end);
+	for(i = i_start; i < i_end; i++)
+	{
+		CalculateHullAabb(grid->bodies[i], grid->aabbs+i);
+		GridCellRange(grid, grid->aabbs+i, cell_min, cell_max);
+		count = (cell_max[0]-cell_min[0]+1)*(cell_max[1]-cell_min[1]+1)*(cell_max[2]-cell_min[2]+1);
+		if(count > GRID_MAX_CELLS_PER_BODY || count <= 0)
+			count = -1; //large body, e.g. the ground
+		grid->cell_counts[i] = count;
+	}
+}
+
+static void GridFillJob(void * user, int i_task)
+{
+	struct grid_struct * grid;
+	struct grid_entry_struct * entry;
+	int cell_min[3];
+	int cell_max[3];
+	int i_start;
+	int i_end;
+	int i;
+	int ix;
+	int iy;
+	int iz;
+
+	grid = (struct grid_struct*)user;
+	GetTaskRange(grid->num_bodies, grid->num_tasks, i_task, &i_start, &i_end);
+	for(i = i_start; i < i_end; i++)
+	{
+		if(grid->cell_counts[i] < 0)
+			continue;
+		entry = grid->entries + grid->cell_offsets[i];
+		GridCellRange(grid, grid->aabbs+i, cell_min, cell_max);
+		for(ix = cell_min[0]; ix <= cell_max[0]; ix++)
+		{
+			for(iy = cell_min[1]; iy <= cell_max[1]; iy++)
+			{
+				for(iz = cell_min[2]; iz <= cell_max[2]; iz++)
+				{
+					entry->hash = GridHashCell(ix, iy, iz);
+					entry->i_body = i;
+					entry += 1;
+				}
+			}
+		}
+	}
+}
+
+static void GridSortJob(void * user, int i_task)
+{
+	struct grid_struct * grid;
+	int i_start;
+	int i_end;
+
+	grid = (struct grid_struct*)user;
+	GetTaskRange(grid->num_entries, grid->num_tasks, i_task, &i_start, &i_end);
+	qsort((grid->entries+i_start), (i_end-i_start), sizeof(struct grid_entry_struct), CompareGridEntries);
+}
+
+//merges sorted chunk runs [a, a+merge_width) and [a+merge_width, a+2*merge_width) into temp_entries
+static void GridMergeJob(void * user, int i_task)
+{
+	struct grid_struct * grid;
+	int first_chunk;
+	int i_start;
+	int i_mid;
+	int i_end;
+	int temp;
+	int i;
+	int j;
+	int k;
+
+	grid = (struct grid_struct*)user;
+	first_chunk = i_task*2*grid->merge_width;
+	GetTaskRange(grid->num_entries, grid->num_tasks, first_chunk, &i_start, &temp);
+	if((first_chunk + grid->merge_width) >= grid->num_tasks)
+	{
+		i_mid = grid->num_entries;
+		i_end = grid->num_entries;
+	}
+	else
+	{
+		GetTaskRange(grid->num_entries, grid->num_tasks, (first_chunk + grid->merge_width), &i_mid, &temp);
+		if((first_chunk + (2*grid->merge_width)) >= grid->num_tasks)
+			i_end = grid->num_entries;
+		else
+			GetTaskRange(grid->num_entries, grid->num_tasks, (first_chunk + (2*grid->merge_width)), &i_end, &temp);
+	}
+
+	i = i_start;
+	j = i_mid;
+	k = i_start;
+	while(i < i_mid && j < i_end)
+	{
+		if(CompareGridEntries((grid->entries+j), (grid->entries+i)) < 0)
+		{
+			grid->temp_entries[k] = grid->entries[j];
+			j += 1;
+		}
+		else
+		{
+			grid->temp_entries[k] = grid->entries[i];
+			i += 1;
+		}
+		k += 1;
+	}
+	while(i < i_mid)
+	{
+		grid->temp_entries[k] = grid->entries[i];
+		i += 1;
+		k += 1;
+	}
+	while(j < i_end)
+	{
+		grid->temp_entries[k] = grid->entries[j];
+		j += 1;
+		k += 1;
+	}
+}
+
+static void GridPairJob(void * user, int i_task)
+{
+	struct grid_struct * grid;
+	struct pair_list_struct * out;
+	struct aabb_struct * a;
+	struct aabb_struct * b;
+	float corner[3];
+	unsigned int hash;
+	int i_run;
+	int i_run_end;
+	int i_start;
+	int i_end;
+	int i_body;
+	int j_body;
+	int i;
+	int j;
+	int k;
+
+	grid = (struct grid_struct*)user;
+	out = grid->task_pairs+i_task;
+	out->num_pairs = 0;
+	out->is_failed = 0;
+
+	//bodies that share a cell
+	i_run = grid->task_ranges[i_task];
+	i_end = grid->task_ranges[i_task+1];
+	while(i_run < i_end)
+	{
+		hash = grid->entries[i_run].hash;
+		i_run_end = i_run+1;
+		while(i_run_end < i_end && grid->entries[i_run_end].hash == hash)
+		{
+			i_run_end += 1;
+		}
+
+		for(i = i_run; i < i_run_end; i++)
+		{
+			i_body = grid->entries[i].i_body;
+			a = grid->aabbs+i_body;
+			for(j = i+1; j < i_run_end; j++)
+			{
+				j_body = grid->entries[j].i_body;
+				if(j_body == i_body)
+					continue;
+				b = grid->aabbs+j_body;
+				if(AabbOverlap(a, b) == 0)
+					continue;
+
+				//only the cell with the min corner of the overlap reports the pair
+				for(k = 0; k < 3; k++)
+				{
+					corner[k] = (a->min[k] > b->min[k]) ? a->min[k] : b->min[k];
+				}
+				if(GridHashCell((int)floorf(corner[0]/grid->cell_size), (int)floorf(corner[1]/grid->cell_size), (int)floorf(corner[2]/grid->cell_size)) != hash)
+					continue;
+
+				if(AddBroadphasePair(&(out->pairs), &(out->num_pairs), &(out->max_pairs), i_body, j_body) == 0)
+				{
+					out->is_failed = 1;
+					return;
+				}
+			}
+		}
+		i_run = i_run_end;
+	}
+
+	//large bodies against this task's share of the bodies
+	GetTaskRange(grid->num_bodies, grid->num_tasks, i_task, &i_start, &i_end);
+	for(k = 0; k < grid->num_large; k++)
+	{
+		i_body = grid->large_bodies[k];
+		for(j_body = i_start; j_body < i_end; j_body++)
+		{
+			if(j_body == i_body)
+				continue;
+			//a pair of large bodies is reported from the higher index
+			if(grid->cell_counts[j_body] < 0 && j_body > i_body)
+				continue;
+			if(AabbOverlap(grid->aabbs+i_body, grid->aabbs+j_body) == 0)
+				continue;
+			if(AddBroadphasePair(&(out->pairs), &(out->num_pairs), &(out->max_pairs), i_body, j_body) == 0)
+			{
+				out->is_failed = 1;
+				return;
+			}
+		}
+	}
+}
+
+static int GridResize(struct grid_struct * grid, int num_bodies)
+{
+	int num_tasks;
+	int i;
+
+	if(num_bodies > grid->max_bodies)
+	{
+		free(grid->aabbs);
+		free(grid->cell_counts);
+		free(grid->cell_offsets);
+		free(grid->large_bodies);
+		grid->aabbs = (struct aabb_struct*)malloc(num_bodies*sizeof(struct aabb_struct));
+		grid->cell_counts = (int*)malloc(num_bodies*sizeof(int));
+		grid->cell_offsets = (int*)malloc(num_bodies*sizeof(int));
+		grid->large_bodies = (int*)malloc(num_bodies*sizeof(int));
+		if(grid->aabbs == 0 || grid->cell_counts == 0 || grid->cell_offsets == 0 || grid->large_bodies == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			grid->max_bodies = 0;
+			return 0;
+		}
+		grid->max_bodies = num_bodies;
+	}
+
+	//a few tasks per thread so uneven cells still balance
+	if(grid->task_pairs == 0)
+	{
+		num_tasks = 1;
+		if(grid->pool != 0)
+			num_tasks = 4*grid->pool->num_threads;
+		grid->task_ranges = (int*)malloc((num_tasks+1)*sizeof(int));
+		grid->task_pairs = (struct pair_list_struct*)malloc(num_tasks*sizeof(struct pair_list_struct));
+		if(grid->task_ranges == 0 || grid->task_pairs == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		for(i = 0; i < num_tasks; i++)
+		{
+			memset((grid->task_pairs+i), 0, sizeof(struct pair_list_struct));
+		}
+		grid->num_tasks = num_tasks;
+	}
+
+	return 1;
+}
+
+static int GridReserveEntries(struct grid_struct * grid, int num_entries)
+{
+	int new_max;
+
+	if(num_entries <= grid->max_entries)
+		return 1;
+
+	new_max = grid->max_entries*2;
+	if(new_max < num_entries)
+		new_max = num_entries;
+	free(grid->entries);
+	free(grid->temp_entries);
+	grid->entries = (struct grid_entry_struct*)malloc(new_max*sizeof(struct grid_entry_struct));
+	grid->temp_entries = (struct grid_entry_struct*)malloc(new_max*sizeof(struct grid_entry_struct));
+	if(grid->entries == 0 || grid->temp_entries == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		grid->max_entries = 0;
+		return 0;
+	}
+	grid->max_entries = new_max;
+
+	return 1;
+}
+
+static void GridCellRange(struct grid_struct * grid, struct aabb_struct * aabb, int * cell_min, int * cell_max)
+{
+	int k;
+
+	for(k = 0; k < 3; k++)
+	{
+		cell_min[k] = (int)floorf(aabb->min[k]/grid->cell_size);
+		cell_max[k] = (int)floorf(aabb->max[k]/grid->cell_size);
+	}
+}
+
+static unsigned int GridHashCell(int ix, int iy, int iz)
+{
+	return (((unsigned int)ix)*73856093u) ^ (((unsigned int)iy)*19349663u) ^ (((unsigned int)iz)*83492791u);
+}
+
+static int CompareGridEntries(const void * a, const void * b)
+{
+	const struct grid_entry_struct * ea = (const struct grid_entry_struct*)a;
+	const struct grid_entry_struct * eb = (const struct grid_entry_struct*)b;
+
+	if(ea->hash != eb->hash)
+		return (ea->hash < eb->hash) ? -1 : 1;
+	return (ea->i_body - eb->i_body);
+}
@@ -0,0 +1,1201 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+
+static int IsParallel(float * a, float * b);
+
+int InitHull(float * positions, int num_positions, struct box_collision_struct * phull)
+{
+	int i;
+	int r;
+
+	//Prolly should make this automated
+	memset(phull, 0, sizeof(struct box_collision_struct));
+
+	phull->num_pos = num_positions;
+	phull->positions = (float*)malloc(num_positions*3*sizeof(float));
+	if(phull->positions == 0)
+		return 0;
+	memcpy(phull->positions, positions, num_positions*3*sizeof(float));
+
+	phull->num_faces = 6;
+	phull->faces = (struct face_struct*)malloc(6*sizeof(struct face_struct));
+	if(phull->faces == 0)
+		return 0;
+	phull->num_face_vertices = 6*4;
+	phull->face_vertices = (int*)malloc(6*4*sizeof(int));
+	if(phull->face_vertices == 0)
+		return 0;
+	for(i = 0; i < 6; i++)
+	{
+		phull->faces[i].i_vertices = phull->face_vertices+(i*4);
+	}
+
+	//+x face
+	phull->faces[0].num_verts = 4;
+	phull->faces[0].normal[0] = 1.0f;
+	phull->faces[0].normal[1] = 0.0f;
+	phull->faces[0].normal[2] = 0.0f;
+	phull->faces[0].i_vertices[0] = 0;
+	phull->faces[0].i_vertices[1] = 4;
+	phull->faces[0].i_vertices[2] = 5;
+	phull->faces[0].i_vertices[3] = 1;
+
+	//+z face
+	phull->faces[1].num_verts = 4;
+	phull->faces[1].normal[0] = 0.0f;
+	phull->faces[1].normal[1] = 0.0f;
+	phull->faces[1].normal[2] = 1.0f;
+	phull->faces[1].i_vertices[0] = 1;
+	phull->faces[1].i_vertices[1] = 5;
+	phull->faces[1].i_vertices[2] = 6;
+	phull->faces[1].i_vertices[3] = 2;
+
+	//-x face
+	phull->faces[2].num_verts = 4;
+	phull->faces[2].normal[0] = -1.0f;
+	phull->faces[2].normal[1] = 0.0f;
+	phull->faces[2].normal[2] = 0.0f;
+	phull->faces[2].i_vertices[0] = 2;
+	phull->faces[2].i_vertices[1] = 6;
+	phull->faces[2].i_vertices[2] = 7;
+	phull->faces[2].i_vertices[3] = 3;
+	
+	//-z face
+	phull->faces[3].num_verts = 4;
+	phull->faces[3].normal[0] = 0.0f;
+	phull->faces[3].normal[1] = 0.0f;
+	phull->faces[3].normal[2] = -1.0f;
+	phull->faces[3].i_vertices[0] = 3;
+	phull->faces[3].i_vertices[1] = 7;
+	phull->faces[3].i_vertices[2] = 4;
+	phull->faces[3].i_vertices[3] = 0;
+
+	//+y face
+	phull->faces[4].num_verts = 4;
+	phull->faces[4].normal[0] = 0.0f;
+	phull->faces[4].normal[1] = 1.0f;
+	phull->faces[4].normal[2] = 0.0f;
+	phull->faces[4].i_vertices[0] = 4;
+	phull->faces[4].i_vertices[1] = 7;
+	phull->faces[4].i_vertices[2] = 6;
+	phull->faces[4].i_vertices[3] = 5;
+
+	//-y face
+	phull->faces[5].num_verts = 4;
+	phull->faces[5].normal[0] = 0.0f;
+	phull->faces[5].normal[1] = -1.0f;
+	phull->faces[5].normal[2] = 0.0f;
+	phull->faces[5].i_vertices[0] = 1;
+	phull->faces[5].i_vertices[1] = 2;
+	phull->faces[5].i_vertices[2] = 3;
+	phull->faces[5].i_vertices[3] = 0;
+
+	phull->num_edges = 12;
+	phull->edges = (struct edge_struct*)malloc(12*sizeof(struct edge_struct));
+	if(phull->edges == 0)
+		return 0;
+
+	//0 - 1
+	//phull->edges[0].normal[0] = 0.0f;
+	//phull->edges[0].normal[1] = 0.0f;
+	//phull->edges[0].normal[2] = 1.0f;
+	phull->edges[0].i_vertices[0] = 0;
+	phull->edges[0].i_vertices[1] = 1;
+	phull->edges[0].i_face[0] = 0;
+	phull->edges[0].i_face[1] = 5;
+	vCrossProduct(phull->edges[0].normal, phull->faces[0].normal, phull->faces[5].normal);
+
+	//1 - 2
+	//phull->edges[1].normal[0] = -1.0f;
+	//phull->edges[1].normal[1] = 0.0f;
+	//phull->edges[1].normal[2] = 0.0f;
+	phull->edges[1].i_vertices[0] = 1;
+	phull->edges[1].i_vertices[1] = 2;
+	phull->edges[1].i_face[0] = 1;
+	phull->edges[1].i_face[1] = 5;
+	vCrossProduct(phull->edges[1].normal, phull->faces[1].normal, phull->faces[5].normal);
+
+	//2 - 3
+	//phull->edges[2].normal[0] = 0.0f;
+	//phull->edges[2].normal[1] = 0.0f;
+	//phull->edges[2].normal[2] = -1.0f;
+	phull->edges[2].i_vertices[0] = 2;
+	phull->edges[2].i_vertices[1] = 3;
+	phull->edges[2].i_face[0] = 2;
+	phull->edges[2].i_face[1] = 5;
+	vCrossProduct(phull->edges[2].normal, phull->faces[2].normal, phull->faces[5].normal);
+
+	//3 - 0
+	//phull->edges[3].normal[0] = 1.0f;
+	//phull->edges[3].normal[1] = 0.0f;
+	//phull->edges[3].normal[2] = 0.0f;
+	phull->edges[3].i_vertices[0] = 3;
+	phull->edges[3].i_vertices[1] = 0;
+	phull->edges[3].i_face[0] = 3;
+	phull->edges[3].i_face[1] = 5;
+	vCrossProduct(phull->edges[3].normal, phull->faces[3].normal, phull->faces[5].normal);
+
+	//4 - 5
+	//phull->edges[4].normal[0] = 0.0f;
+	//phull->edges[4].normal[1] = 0.0f;
+	//phull->edges[4].normal[2] = -1.0f;
+	phull->edges[4].i_vertices[0] = 4;
+	phull->edges[4].i_vertices[1] = 5;
+	phull->edges[4].i_face[0] = 4;
+	phull->edges[4].i_face[1] = 0;
+	vCrossProduct(phull->edges[4].normal, phull->faces[4].normal, phull->faces[0].normal);
+
+	//5 - 6
+	//phull->edges[5].normal[0] = -1.0f;
+	//phull->edges[5].normal[1] = 0.0f;
+	//phull->edges[5].normal[2] = 0.0f;
+	phull->edges[5].i_vertices[0] = 5;
+	phull->edges[5].i_vertices[1] = 6;
+	phull->edges[5].i_face[0] = 4;
+	phull->edges[5].i_face[1] = 1;
+	vCrossProduct(phull->edges[5].normal, phull->faces[4].normal, phull->faces[1].normal);
+
+	//6 - 7
+	//phull->edges[6].normal[0] = 0.0f;
+	//phull->edges[6].normal[1] = 0.0f;
+	//phull->edges[6].normal[2] = -1.0f;
+	phull->edges[6].i_vertices[0] = 6;
+	phull->edges[6].i_vertices[1] = 7;
+	phull->edges[6].i_face[0] = 4;
+	phull->edges[6].i_face[1] = 2;
+	vCrossProduct(phull->edges[6].normal, phull->faces[4].normal, phull->faces[2].normal);
+
+	//7 - 4
+	//phull->edges[7].normal[0] = 1.0f;
+	//phull->edges[7].normal[1] = 0.0f;
+	//phull->edges[7].normal[2] = 0.0f;
+	phull->edges[7].i_vertices[0] = 7;
+	phull->edges[7].i_vertices[1] = 4;
+	phull->edges[7].i_face[0] = 4;
+	phull->edges[7].i_face[1] = 3;
+	vCrossProduct(phull->edges[7].normal, phull->faces[4].normal, phull->faces[3].normal);
+
+	//0 - 4
+	//phull->edges[8].normal[0] = 0.0f;
+	//phull->edges[8].normal[1] = 1.0f;
+	//phull->edges[8].normal[2] = 0.0f;
+	phull->edges[8].i_vertices[0] = 0;
+	phull->edges[8].i_vertices[1] = 4;
+	phull->edges[8].i_face[0] = 0;
+	phull->edges[8].i_face[1] = 3;
+	vCrossProduct(phull->edges[8].normal, phull->faces[0].normal, phull->faces[3].normal);
+
+	//1 - 5
+	//phull->edges[9].normal[0] = 0.0f;
+	//phull->edges[9].normal[1] = 1.0f;
+	//phull->edges[9].normal[2] = 0.0f;
+	phull->edges[9].i_vertices[0] = 1;
+	phull->edges[9].i_vertices[1] = 5;
+	phull->edges[9].i_face[0] = 0;
+	phull->edges[9].i_face[1] = 1;
+	vCrossProduct(phull->edges[9].normal, phull->faces[0].normal, phull->faces[1].normal);
+
+	//2 - 6
+	//phull->edges[10].normal[0] = 0.0f;
+	//phull->edges[10].normal[1] = 1.0f;
+	//phull->edges[10].normal[2] = 0.0f;
+	phull->edges[10].i_vertices[0] = 2;
+	phull->edges[10].i_vertices[1] = 6;
+	phull->edges[10].i_face[0] = 1;
+	phull->edges[10].i_face[1] = 2;
+	vCrossProduct(phull->edges[10].normal, phull->faces[1].normal, phull->faces[2].normal);
+
+	//3 - 7
+	//phull->edges[0].normal[0] = 0.0f;
+	//phull->edges[0].normal[1] = 1.0f;
+	//phull->edges[0].normal[2] = 0.0f;
+	phull->edges[11].i_vertices[0] = 3;
+	phull->edges[11].i_vertices[1] = 7;
+	phull->edges[11].i_face[0] = 2;
+	phull->edges[11].i_face[1] = 3;
+	vCrossProduct(phull->edges[11].normal, phull->faces[2].normal, phull->faces[3].normal);
+
+	InitHullBoxExtents(phull);
+	r = InitHullAxisGroups(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullArcs(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullAdjacency(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullHalfEdges(phull);
+	if(r == 0)
+		return 0;
+
+	return InitHullSoa(phull);
+}
+
+int InitPlaneHull(float * positions, int num_positions, struct box_collision_struct * phull)
+{
+	int r;
+
+	memset(phull, 0, sizeof(struct box_collision_struct));
+
+	phull->positions = (float*)malloc(num_positions*3*sizeof(float));
+	if(phull->positions == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	phull->num_pos =  num_positions;
+	memcpy(phull->positions, positions, 3*num_positions*sizeof(float));
+
+	//faces
+	phull->num_faces = 2;
+	phull->faces = (struct face_struct*)malloc(2*sizeof(struct face_struct));
+	if(phull->faces == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	phull->num_face_vertices = 2*4;
+	phull->face_vertices = (int*)malloc(2*4*sizeof(int));
+	if(phull->face_vertices == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	phull->faces[0].i_vertices = phull->face_vertices;
+	phull->faces[1].i_vertices = phull->face_vertices+4;
+
+	phull->faces[0].normal[0] = 0.0f;
+	phull->faces[0].normal[1] = 1.0f;
+	phull->faces[0].normal[2] = 0.0f;
+	phull->faces[0].num_verts = 4;
+	phull->faces[0].i_vertices[0] = 0;
+	phull->faces[0].i_vertices[1] = 1;
+	phull->faces[0].i_vertices[2] = 2;
+	phull->faces[0].i_vertices[3] = 3;
+
+	phull->faces[1].normal[0] = 0.0f;
+	phull->faces[1].normal[1] = -1.0f;
+	phull->faces[1].normal[2] = 0.0f;
+	phull->faces[1].num_verts = 4;
+	phull->faces[1].i_vertices[0] = 3;
+	phull->faces[1].i_vertices[1] = 2;
+	phull->faces[1].i_vertices[2] = 1;
+	phull->faces[1].i_vertices[3] = 0;
+
+	//edges
+	phull->num_edges = 4;
+	phull->edges = (struct edge_struct*)malloc(4*sizeof(struct edge_struct));
+	if(phull->edges == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+
+	//0 - 1
+	phull->edges[0].i_vertices[0] = 0;
+	phull->edges[0].i_vertices[1] = 1;
+	phull->edges[0].i_face[0] = 1;
+	phull->edges[0].i_face[1] = 0;
+	phull->edges[0].normal[0] = -1.0f;
+	phull->edges[0].normal[1] = 0.0f;
+	phull->edges[0].normal[2] = 0.0f;
+
+	//1 - 2
+	phull->edges[1].i_vertices[0] = 1;
+	phull->edges[1].i_vertices[1] = 2;
+	phull->edges[1].i_face[0] = 1;
+	phull->edges[1].i_face[1] = 0;
+	phull->edges[1].normal[0] = 0.0f;
+	phull->edges[1].normal[1] = 0.0f;
+	phull->edges[1].normal[2] = 1.0f;
+
+	//2 - 3
+	phull->edges[2].i_vertices[0] = 2;
+	phull->edges[2].i_vertices[1] = 3;
+	phull->edges[2].i_face[0] = 1;
+	phull->edges[2].i_face[1] = 0;
+	phull->edges[2].normal[0] = 1.0f;
+	phull->edges[2].normal[1] = 0.0f;
+	phull->edges[2].normal[2] = 0.0f;
+
+	//3 - 0
+	phull->edges[3].i_vertices[0] = 3;
+	phull->edges[3].i_vertices[1] = 0;
+	phull->edges[3].i_face[0] = 1;
+	phull->edges[3].i_face[1] = 0;
+	phull->edges[3].normal[0] = 0.0f;
+	phull->edges[3].normal[1] = 0.0f;
+	phull->edges[3].normal[2] = -1.0f;
+
+	r = InitHullAxisGroups(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullArcs(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullAdjacency(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullHalfEdges(phull);
+	if(r == 0)
+		return 0;
+
+	return InitHullSoa(phull);
+}
+
+//UpdateHull transforms the hull to the current orientation/position of the box.
+void UpdateHull(struct box_collision_struct * base_hull, struct box_struct * box)
+{
+	struct box_collision_struct * hull;
+	int i;
+
+	hull = box->hull;
+
+	//a body that uses its shape directly has nothing to update
+	if(hull->is_local == 1)
+		return;
+
+	//Transform the copy of the hull to world coordinates
+	for(i = 0; i < hull->num_pos; i++)
+	{
+		hull->positions[(i*3)] = base_hull->positions[(i*3)];
+		hull->positions[(i*3)+1] = base_hull->positions[(i*3)+1];
+		hull->positions[(i*3)+2] = base_hull->positions[(i*3)+2];
+		mmTransformVec3(box->orientation, (hull->positions+(i*3)));
+		hull->positions[(i*3)] += box->pos[0];
+		hull->positions[(i*3)+1] += box->pos[1];
+		hull->positions[(i*3)+2] += box->pos[2];
+	}
+	for(i = 0; i < hull->num_faces; i++)
+	{
+		hull->faces[i].normal[0] = base_hull->faces[i].normal[0];
+		hull->faces[i].normal[1] = base_hull->faces[i].normal[1];
+		hull->faces[i].normal[2] = base_hull->faces[i].normal[2];
+		mmTransformVec3(box->orientation, hull->faces[i].normal);
+	}
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		hull->edges[i].normal[0] = base_hull->edges[i].normal[0];
+		hull->edges[i].normal[1] = base_hull->edges[i].normal[1];
+		hull->edges[i].normal[2] = base_hull->edges[i].normal[2];
+		mmTransformVec3(box->orientation, hull->edges[i].normal);
+	}
+	for(i = 0; i < hull->num_edges && hull->arcs != 0; i++)
+	{
+		memcpy(hull->arcs+i, base_hull->arcs+i, sizeof(struct gauss_arc_struct));
+		mmTransformVec3(box->orientation, hull->arcs[i].a);
+		mmTransformVec3(box->orientation, hull->arcs[i].b);
+		mmTransformVec3(box->orientation, hull->arcs[i].bxa);
+	}
+	UpdateHullSoa(hull);
+}
+
+int CopyHull(struct box_collision_struct * dest, struct box_collision_struct * src)
+{
+	int i;
+	int r;
+
+	//positions
+	dest->positions = (float*)malloc(src->num_pos*3*sizeof(float));
+	if(dest->positions == 0)
+		return 0;
+	dest->num_pos = src->num_pos;
+	for(i = 0; i < src->num_pos; i++)
+	{
+		dest->positions[(i*3)] = src->positions[(i*3)];
+		dest->positions[(i*3)+1] = src->positions[(i*3)+1];
+		dest->positions[(i*3)+2] = src->positions[(i*3)+2];
+	}
+
+	//faces
+	dest->faces = (struct face_struct*)malloc(src->num_faces*sizeof(struct face_struct));
+	if(dest->faces == 0)
+		return 0;
+	dest->num_faces = src->num_faces;
+	dest->face_vertices = (int*)malloc(src->num_face_vertices*sizeof(int));
+	if(dest->face_vertices == 0)
+		return 0;
+	dest->num_face_vertices = src->num_face_vertices;
+	memcpy(dest->face_vertices, src->face_vertices, src->num_face_vertices*sizeof(int));
+	for(i = 0; i < src->num_faces; i++)
+	{
+		memcpy(dest->faces+i, src->faces+i, sizeof(struct face_struct));
+		dest->faces[i].i_vertices = dest->face_vertices+(src->faces[i].i_vertices-src->face_vertices);
+	}
+
+	//edges
+	dest->edges = (struct edge_struct*)malloc(src->num_edges*sizeof(struct edge_struct));
+	if(dest->edges == 0)
+		return 0;
+	dest->num_edges = src->num_edges;
+	for(i = 0; i < src->num_edges; i++)
+	{
+		memcpy(dest->edges+i, src->edges+i, sizeof(struct edge_struct));
+	}
+
+	dest->is_box = src->is_box;
+	memcpy(dest->half_extents, src->half_extents, 3*sizeof(float));
+	memcpy(dest->box_face, src->box_face, sizeof(src->box_face));
+	dest->is_local = 0;
+	r = InitHullAxisGroups(dest);
+	if(r == 0)
+		return 0;
+	r = InitHullArcs(dest);
+	if(r == 0)
+		return 0;
+	r = InitHullAdjacency(dest);
+	if(r == 0)
+		return 0;
+	r = InitHullHalfEdges(dest);
+	if(r == 0)
+		return 0;
+	dest->use_hill_climb = src->use_hill_climb;
+
+	return InitHullSoa(dest);
+}
+
+/*
+Allocates the structure-of-arrays copy of the hull positions used by FindSupportSoa().
+The arrays are padded to SAT_SIMD_WIDTH with copies of vertex 0, which never
+change the result of a support query.
+*/
+int InitHullSoa(struct box_collision_struct * hull)
+{
+	void * mem=0;
+	int num_soa;
+	int r;
+
+	hull->soa = 0;
+	hull->num_soa = 0;
+	if(hull->num_pos <= 0)
+		return 1;
+
+	num_soa = ((hull->num_pos + SAT_SIMD_WIDTH - 1)/SAT_SIMD_WIDTH)*SAT_SIMD_WIDTH;
+	r = posix_memalign(&mem, (SAT_SIMD_WIDTH*sizeof(float)), (3*num_soa*sizeof(float)));
+	if(r != 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	hull->soa = (float*)mem;
+	hull->num_soa = num_soa;
+	UpdateHullSoa(hull);
+
+	return 1;
+}
+
+//copies hull->positions into hull->soa. Needs to be called after the positions change.
+void UpdateHullSoa(struct box_collision_struct * hull)
+{
+	float * x;
+	float * y;
+	float * z;
+	int i;
+
+	if(hull->soa == 0)
+		return;
+
+	x = hull->soa;
+	y = hull->soa + hull->num_soa;
+	z = hull->soa + (2*hull->num_soa);
+	for(i = 0; i < hull->num_soa; i++)
+	{
+		if(i < hull->num_pos)
+		{
+			x[i] = hull->positions[(i*3)];
+			y[i] = hull->positions[(i*3)+1];
+			z[i] = hull->positions[(i*3)+2];
+		}
+		else
+		{
+			x[i] = x[0];
+			y[i] = y[0];
+			z[i] = z[0];
+		}
+	}
+}
+
+/*
+Marks the hull as a box for FindSeparatingAxisBox() if its vertices are the corners of
+an axis aligned box centered on the origin. The face of each axis direction is looked
+up from the face normals, so it doesn't matter in what order the builder made the faces.
+*/
+void InitHullBoxExtents(struct box_collision_struct * phull)
+{
+	float * normal;
+	float d;
+	int side;
+	int i;
+	int k;
+
+	phull->is_box = 0;
+	if(phull->num_pos != 8 || phull->num_faces != 6 || phull->num_edges != 12)
+		return;
+
+	for(k = 0; k < 3; k++)
+	{
+		phull->half_extents[k] = fabsf(phull->positions[k]);
+	}
+	for(i = 0; i < phull->num_pos; i++)
+	{
+		for(k = 0; k < 3; k++)
+		{
+			d = fabsf(phull->positions[(i*3)+k]) - phull->half_extents[k];
+			if(fabsf(d) > 0.000001f)
+				return;
+		}
+	}
+
+	memset(phull->box_face, -1, sizeof(phull->box_face));
+	for(i = 0; i < phull->num_faces; i++)
+	{
+		normal = phull->faces[i].normal;
+		for(k = 0; k < 3; k++)
+		{
+			if(fabsf(normal[k]) > 0.999f)
+				break;
+		}
+		if(k == 3)
+			return;
+		side = (normal[k] > 0.0f) ? 0 : 1;
+		if(phull->box_face[k][side] != -1)
+			return;
+		phull->box_face[k][side] = i;
+	}
+	phull->is_box = 1;
+}
+
+/*
+Groups the faces and the edges of the hull by direction, ignoring the sign, so the
+separating axis search only has to test each direction once. The axis of a group is
+the normal of its first member, which UpdateHull() keeps in world space. Hulls with
+more than SAT_MAX_AXIS_GROUPS face directions are left without groups.
+*/
+int InitHullAxisGroups(struct box_collision_struct * hull)
+{
+	int * edge_group=0;
+	int num_groups;
+	int i;
+	int j;
+	int k;
+
+	hull->face_groups = 0;
+	hull->face_group = 0;
+	hull->num_face_groups = 0;
+	hull->edge_groups = 0;
+	hull->edge_group_members = 0;
+	hull->num_edge_groups = 0;
+
+	if(hull->num_faces > 0)
+	{
+		hull->face_groups = (struct axis_group_struct*)malloc(hull->num_faces*sizeof(struct axis_group_struct));
+		hull->face_group = (int*)malloc(hull->num_faces*sizeof(int));
+		if(hull->face_groups == 0 || hull->face_group == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+	}
+	num_groups = 0;
+	for(i = 0; i < hull->num_faces; i++)
+	{
+		for(j = 0; j < num_groups; j++)
+		{
+			if(IsParallel(hull->faces[i].normal, hull->faces[hull->face_groups[j].i_rep].normal) == 1)
+				break;
+		}
+		if(j == num_groups)
+		{
+			//the unique axis search isn't used for hulls with this many face directions,
+			//leave the hull ungrouped instead of spending O(n^2) on groups nobody reads
+			if(num_groups == SAT_MAX_AXIS_GROUPS)
+			{
+				free(hull->face_groups);
+				free(hull->face_group);
+				hull->face_groups = 0;
+				hull->face_group = 0;
+				return 1;
+			}
+			hull->face_groups[j].i_rep = i;
+			hull->face_groups[j].i_first = 0;
+			hull->face_groups[j].num_members = 0;
+			num_groups += 1;
+		}
+		hull->face_group[i] = j;
+		hull->face_groups[j].num_members += 1;
+	}
+	hull->num_face_groups = num_groups;
+
+	if(hull->num_edges > 0)
+	{
+		hull->edge_groups = (struct axis_group_struct*)malloc(hull->num_edges*sizeof(struct axis_group_struct));
+		hull->edge_group_members = (int*)malloc(hull->num_edges*sizeof(int));
+		edge_group = (int*)malloc(hull->num_edges*sizeof(int));
+		if(hull->edge_groups == 0 || hull->edge_group_members == 0 || edge_group == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			free(edge_group);
+			return 0;
+		}
+	}
+	num_groups = 0;
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		for(j = 0; j < num_groups; j++)
+		{
+			if(IsParallel(hull->edges[i].normal, hull->edges[hull->edge_groups[j].i_rep].normal) == 1)
+				break;
+		}
+		if(j == num_groups)
+		{
+			hull->edge_groups[j].i_rep = i;
+			hull->edge_groups[j].num_members = 0;
+			num_groups += 1;
+		}
+		edge_group[i] = j;
+		hull->edge_groups[j].num_members += 1;
+	}
+	hull->num_edge_groups = num_groups;
+
+	//members of each edge group are stored together
+	k = 0;
+	for(j = 0; j < hull->num_edge_groups; j++)
+	{
+		hull->edge_groups[j].i_first = k;
+		for(i = 0; i < hull->num_edges; i++)
+		{
+			if(edge_group[i] == j)
+			{
+				hull->edge_group_members[k] = i;
+				k += 1;
+			}
+		}
+	}
+	free(edge_group);
+
+	return 1;
+}
+
+//returns 1 if a and b point along the same line
+static int IsParallel(float * a, float * b)
+{
+	float cross_vec[3];
+	float mag_a;
+	float mag_b;
+	float dot;
+
+	//most pairs are far from parallel, skip the cross product and square roots for them
+	dot = vDotProduct(a, b);
+	if((dot*dot) < (0.99f*vDotProduct(a, a)*vDotProduct(b, b)))
+		return 0;
+	mag_a = vMagnitude(a);
+	mag_b = vMagnitude(b);
+	if(mag_a == 0.0f || mag_b == 0.0f)
+		return 0;
+	vCrossProduct(cross_vec, a, b);
+	if(vMagnitude(cross_vec) <= (0.0001f*mag_a*mag_b))
+		return 1;
+	return 0;
+}
+
+/*
+Builds the Gauss map arc of every edge from the normals of its two faces. The arcs are
+made in the frame the hull is built in and UpdateHull() rotates them with the rest of
+the hull, so the edge-edge test doesn't need any cross products.
+*/
+int InitHullArcs(struct box_collision_struct * hull)
+{
+	struct gauss_arc_struct * arc;
+	struct edge_struct * edge;
+	float mag;
+	int i;
+
+	hull->arcs = 0;
+	if(hull->num_edges <= 0)
+		return 1;
+
+	hull->arcs = (struct gauss_arc_struct*)malloc(hull->num_edges*sizeof(struct gauss_arc_struct));
+	if(hull->arcs == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		arc = hull->arcs+i;
+		edge = hull->edges+i;
+		memcpy(arc->a, hull->faces[edge->i_face[0]].normal, 3*sizeof(float));
+		memcpy(arc->b, hull->faces[edge->i_face[1]].normal, 3*sizeof(float));
+		vCrossProduct(arc->bxa, arc->b, arc->a);
+		arc->is_antipodal = 0;
+		if(vMagnitude(arc->bxa) < 0.000001f)
+		{
+			//the arc is half of any great circle through a and -a. use the one
+			//perpendicular to the edge
+			vSubtract(arc->bxa, (hull->positions+(edge->i_vertices[1]*3)), (hull->positions+(edge->i_vertices[0]*3)));
+			mag = vMagnitude(arc->bxa);
+			if(mag > 0.0f)
+			{
+				arc->bxa[0] /= mag;
+				arc->bxa[1] /= mag;
+				arc->bxa[2] /= mag;
+			}
+			arc->is_antipodal = 1;
+		}
+	}
+
+	return 1;
+}
+
+//frees the arrays of a hull made by InitHull(), InitPlaneHull() or CopyHull()
+void FreeHull(struct box_collision_struct * hull)
+{
+	free(hull->positions);
+	free(hull->faces);
+	free(hull->face_vertices);
+	free(hull->edges);
+	free(hull->soa);
+	free(hull->face_groups);
+	free(hull->face_group);
+	free(hull->edge_groups);
+	free(hull->edge_group_members);
+	free(hull->arcs);
+	free(hull->adj_first);
+	free(hull->adj);
+	free(hull->half_edges);
+	free(hull->vertex_half_edge);
+	free(hull->clip_scratch);
+	free(hull->clip_id_scratch);
+	memset(hull, 0, sizeof(struct box_collision_struct));
+}
+
+//returns the bytes of the arrays of the hull
+int HullMemorySize(struct box_collision_struct * hull)
+{
+	int size;
+
+	size = hull->num_pos*3*sizeof(float);
+	size += hull->num_faces*sizeof(struct face_struct);
+	size += hull->num_face_vertices*sizeof(int);
+	size += hull->num_edges*sizeof(struct edge_struct);
+	if(hull->soa != 0)
+		size += hull->num_soa*3*sizeof(float);
+	//the group arrays are allocated for the worst case of one group per face or edge
+	if(hull->face_groups != 0)
+		size += hull->num_faces*(sizeof(struct axis_group_struct)+sizeof(int));
+	if(hull->edge_groups != 0)
+		size += hull->num_edges*(sizeof(struct axis_group_struct)+sizeof(int));
+	if(hull->arcs != 0)
+		size += hull->num_edges*sizeof(struct gauss_arc_struct);
+	if(hull->adj_first != 0)
+		size += ((hull->num_pos+1)*sizeof(int)) + ((2*hull->num_edges+1)*sizeof(int));
+	if(hull->half_edges != 0)
+		size += (hull->num_half_edges*sizeof(struct half_edge_struct)) + (hull->num_pos*sizeof(int));
+	if(hull->clip_scratch != 0)
+		size += hull->max_face_verts*((10*sizeof(float))+(3*sizeof(int)));
+
+	return size;
+}
+
+/*
+The functions below work on the hull of a body whether it is a world space copy or the
+body's shape in local space (hull->is_local). For a local hull the query is moved into
+the body's frame instead, one 3x3 multiply per axis instead of one per vertex, and only
+the vertices used for contacts are moved to world space.
+*/
+
+//world space position of a vertex
+void HullGetPosition(struct box_struct * box, int i_vertex, float * pos)
+{
+	memcpy(pos, (box->hull->positions+(i_vertex*3)), 3*sizeof(float));
+	if(box->hull->is_local == 0)
+		return;
+	mmTransformVec3(box->orientation, pos);
+	pos[0] += box->pos[0];
+	pos[1] += box->pos[1];
+	pos[2] += box->pos[2];
+}
+
+//world space normal of a face
+void HullGetFaceNormal(struct box_struct * box, int i_face, float * normal)
+{
+	memcpy(normal, box->hull->faces[i_face].normal, 3*sizeof(float));
+	if(box->hull->is_local == 1)
+		mmTransformVec3(box->orientation, normal);
+}
+
+//world space direction of an edge
+void HullGetEdgeNormal(struct box_struct * box, int i_edge, float * normal)
+{
+	memcpy(normal, box->hull->edges[i_edge].normal, 3*sizeof(float));
+	if(box->hull->is_local == 1)
+		mmTransformVec3(box->orientation, normal);
+}
+
+//rotates a world space direction into the frame of the hull's positions and normals
+void HullToLocalDir(struct box_struct * box, float * dir, float * local_dir)
+{
+	float temp_vec[3];
+	int k;
+
+	if(box->hull->is_local == 0)
+	{
+		memcpy(local_dir, dir, 3*sizeof(float));
+		return;
+	}
+	//the columns of the orientation are the body's axes
+	for(k = 0; k < 3; k++)
+	{
+		temp_vec[k] = vDotProduct(dir, (box->orientation+(k*3)));
+	}
+	memcpy(local_dir, temp_vec, 3*sizeof(float));
+}
+
+//min and max of the hull's world space vertices along a world space dir
+void ProjectHull(struct box_struct * box, float * dir, float * min_dot, float * max_dot)
+{
+	ProjectHullWarm(box, dir, min_dot, max_dot, 0);
+}
+
+/*
+ProjectHull() for repeated queries. 'warm' holds the vertices of the min and max from
+the last query and is updated. Hill climbing hulls start walking there, it may be 0.
+*/
+void ProjectHullWarm(struct box_struct * box, float * dir, float * min_dot, float * max_dot, int * warm)
+{
+	struct box_collision_struct * hull;
+	float local_dir[3];
+	float offset;
+	float d;
+	int i_min;
+	int i_max;
+	int i;
+
+	hull = box->hull;
+	HullToLocalDir(box, dir, local_dir);
+	if(hull->use_hill_climb == 1)
+	{
+		i_min = FindSupportHillClimb(hull, local_dir, ((warm != 0) ? warm[0] : 0), min_dot);
+		local_dir[0] = -local_dir[0];
+		local_dir[1] = -local_dir[1];
+		local_dir[2] = -local_dir[2];
+		i_max = FindSupportHillClimb(hull, local_dir, ((warm != 0) ? warm[1] : 0), max_dot);
+		*max_dot = -(*max_dot);
+		if(warm != 0)
+		{
+			warm[0] = i_min;
+			warm[1] = i_max;
+		}
+	}
+	else if(hull->soa != 0)
+	{
+		ProjectSoa(hull->soa, hull->num_soa, local_dir, min_dot, max_dot);
+	}
+	else
+	{
+		for(i = 0; i < hull->num_pos; i++)
+		{
+			d = vDotProduct(local_dir, (hull->positions+(i*3)));
+			if(i == 0 || d < *min_dot)
+				*min_dot = d;
+			if(i == 0 || d > *max_dot)
+				*max_dot = d;
+		}
+	}
+	if(hull->is_local == 1)
+	{
+		offset = vDotProduct(dir, box->pos);
+		*min_dot += offset;
+		*max_dot += offset;
+	}
+}
+
+/*
+Returns the vertex with the smallest projection on a world space dir and sets min_dot to
+that projection. 'warm' is the vertex the last query returned, hill climbing starts
+there and it is updated. It may be 0.
+*/
+int HullFindSupport(struct box_struct * box, float * dir, int * warm, float * min_dot)
+{
+	struct box_collision_struct * hull;
+	float local_dir[3];
+	float d;
+	int i_min=0;
+	int i;
+
+	hull = box->hull;
+	HullToLocalDir(box, dir, local_dir);
+	if(hull->use_hill_climb == 1)
+	{
+		i_min = FindSupportHillClimb(hull, local_dir, ((warm != 0) ? *warm : 0), min_dot);
+		if(warm != 0)
+			*warm = i_min;
+	}
+	else if(hull->soa != 0)
+	{
+		i_min = FindSupportSoa(hull->soa, hull->num_soa, local_dir, min_dot);
+	}
+	else
+	{
+		for(i = 0; i < hull->num_pos; i++)
+		{
+			d = vDotProduct(local_dir, (hull->positions+(i*3)));
+			if(i == 0 || d < *min_dot)
+			{
+				*min_dot = d;
+				i_min = i;
+			}
+		}
+	}
+	if(hull->is_local == 1)
+		*min_dot += vDotProduct(dir, box->pos);
+
+	return i_min;
+}
+
+/*
+Builds the vertex adjacency used by FindSupportHillClimb() from the edges, and turns
+hill climbing on for hulls with at least SAT_HILL_CLIMB_MIN_VERTS vertices. Below that
+the simd scan of every vertex is faster. use_hill_climb can be changed after this.
+*/
+int InitHullAdjacency(struct box_collision_struct * hull)
+{
+	struct edge_struct * edge;
+	int * num_adj;
+	int i;
+	int k;
+
+	hull->adj_first = (int*)calloc((hull->num_pos+1), sizeof(int));
+	hull->adj = (int*)malloc((2*hull->num_edges+1)*sizeof(int));
+	num_adj = (int*)calloc((hull->num_pos+1), sizeof(int));
+	if(hull->adj_first == 0 || hull->adj == 0 || num_adj == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		free(num_adj);
+		return 0;
+	}
+
+	//count the neighbors of each vertex, then prefix sum them into adj_first
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		edge = hull->edges+i;
+		hull->adj_first[edge->i_vertices[0]+1] += 1;
+		hull->adj_first[edge->i_vertices[1]+1] += 1;
+	}
+	for(i = 0; i < hull->num_pos; i++)
+	{
+		hull->adj_first[i+1] += hull->adj_first[i];
+	}
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		edge = hull->edges+i;
+		k = edge->i_vertices[0];
+		hull->adj[hull->adj_first[k]+num_adj[k]] = edge->i_vertices[1];
+		num_adj[k] += 1;
+		k = edge->i_vertices[1];
+		hull->adj[hull->adj_first[k]+num_adj[k]] = edge->i_vertices[0];
+		num_adj[k] += 1;
+	}
+	free(num_adj);
+
+	hull->use_hill_climb = (hull->num_pos >= SAT_HILL_CLIMB_MIN_VERTS) ? 1 : 0;
+
+	return 1;
+}
+
+/*
+Builds the half edges of the hull from the vertex loops of its faces. Every edge must be
+used by two faces, once in each direction. Hulls with faces bigger than
+SAT_CLIP_STACK_VERTS also get the clip scratch of CreateFaceContact() here, so making a
+contact never allocates. Copies made by HullPoolInit() share it with their shape, the
+contacts of a shape's bodies must be made from one thread.
+returns 0 if the faces don't make a closed hull.
+*/
+int InitHullHalfEdges(struct box_collision_struct * hull)
+{
+	struct half_edge_struct * half_edge;
+	struct face_struct * face;
+	struct edge_struct * edge=0;
+	int * vertex_first;	//edges at vertex i are vertex_edges[vertex_first[i]] .. vertex_edges[vertex_first[i+1]-1]
+	int * vertex_edges;
+	int * num_vertex_edges;
+	int a;
+	int b;
+	int h;
+	int h_prev;
+	int i;
+	int j;
+	int k;
+
+	hull->num_half_edges = 2*hull->num_edges;
+	hull->half_edges = (struct half_edge_struct*)malloc((hull->num_half_edges+1)*sizeof(struct half_edge_struct));
+	hull->vertex_half_edge = (int*)malloc((hull->num_pos+1)*sizeof(int));
+	vertex_first = (int*)calloc((hull->num_pos+1), sizeof(int));
+	vertex_edges = (int*)malloc((2*hull->num_edges+1)*sizeof(int));
+	num_vertex_edges = (int*)calloc((hull->num_pos+1), sizeof(int));
+	if(hull->half_edges == 0 || hull->vertex_half_edge == 0 || vertex_first == 0 || vertex_edges == 0 || num_vertex_edges == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		free(vertex_first);
+		free(vertex_edges);
+		free(num_vertex_edges);
+		return 0;
+	}
+
+	//edges at each vertex, to find the edge of a pair of vertices
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		vertex_first[hull->edges[i].i_vertices[0]+1] += 1;
+		vertex_first[hull->edges[i].i_vertices[1]+1] += 1;
+	}
+	for(i = 0; i < hull->num_pos; i++)
+	{
+		vertex_first[i+1] += vertex_first[i];
+	}
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		for(k = 0; k < 2; k++)
+		{
+			j = hull->edges[i].i_vertices[k];
+			vertex_edges[vertex_first[j]+num_vertex_edges[j]] = i;
+			num_vertex_edges[j] += 1;
+		}
+	}
+
+	for(h = 0; h < hull->num_half_edges; h++)
+	{
+		edge = hull->edges+(h/2);
+		half_edge = hull->half_edges+h;
+		half_edge->i_vertex = edge->i_vertices[h%2];
+		half_edge->i_twin = h^1;
+		half_edge->i_next = -1;
+		half_edge->i_face = -1;
+	}
+	for(i = 0; i < hull->num_pos; i++)
+	{
+		hull->vertex_half_edge[i] = -1;
+	}
+
+	for(i = 0; i < hull->num_faces; i++)
+	{
+		face = hull->faces+i;
+		h_prev = -1;
+		for(k = 0; k <= face->num_verts; k++)
+		{
+			a = face->i_vertices[k%face->num_verts];
+			b = face->i_vertices[(k+1)%face->num_verts];
+			for(j = vertex_first[a]; j < vertex_first[a+1]; j++)
+			{
+				edge = hull->edges+vertex_edges[j];
+				if((edge->i_vertices[0] == a && edge->i_vertices[1] == b) || (edge->i_vertices[0] == b && edge->i_vertices[1] == a))
+					break;
+			}
+			if(j == vertex_first[a+1])
+			{
+				printf("%s: error line %d\n", __func__, __LINE__);
+				break;
+			}
+			h = 2*vertex_edges[j] + ((edge->i_vertices[0] == a) ? 0 : 1);
+			if(k == face->num_verts)
+			{
+				//back at the first half edge, close the loop
+				hull->half_edges[h_prev].i_next = h;
+				break;
+			}
+			if(hull->half_edges[h].i_face != -1)
+			{
+				printf("%s: error line %d\n", __func__, __LINE__);
+				break;
+			}
+			hull->half_edges[h].i_face = i;
+			if(h_prev == -1)
+				face->i_half_edge = h;
+			else
+				hull->half_edges[h_prev].i_next = h;
+			hull->vertex_half_edge[a] = h;
+			h_prev = h;
+		}
+		if(k != face->num_verts)
+			break;
+	}
+	free(vertex_first);
+	free(vertex_edges);
+	free(num_vertex_edges);
+	if(i != hull->num_faces)
+		return 0;
+	for(h = 0; h < hull->num_half_edges; h++)
+	{
+		if(hull->half_edges[h].i_face == -1)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+	}
+
+	hull->max_face_verts = 0;
+	for(i = 0; i < hull->num_faces; i++)
+	{
+		if(hull->faces[i].num_verts > hull->max_face_verts)
+			hull->max_face_verts = hull->faces[i].num_verts;
+	}
+	hull->clip_scratch = 0;
+	hull->clip_id_scratch = 0;
+	if(hull->max_face_verts > SAT_CLIP_STACK_VERTS)
+	{
+		hull->clip_scratch = (float*)malloc(hull->max_face_verts*10*sizeof(float));
+		hull->clip_id_scratch = (int*)malloc(hull->max_face_verts*3*sizeof(int));
+		if(hull->clip_scratch == 0 || hull->clip_id_scratch == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/*
+Support query that walks the vertex adjacency from i_start to the neighbor with the
+smallest projection on dir until no neighbor is smaller. On a convex hull the vertex
+it stops at is a global minimum, and starting from last step's support vertex it
+usually takes a step or two. dir is in the frame of the hull's positions.
+returns the vertex, min_dot is set to its projection.
+*/
+int FindSupportHillClimb(struct box_collision_struct * hull, float * dir, int i_start, float * min_dot)
+{
+	float best;
+	float d;
+	int i_best;
+	int i_next;
+	int k;
+
+	if(i_start < 0 || i_start >= hull->num_pos)
+		i_start = 0;
+	i_best = i_start;
+	best = vDotProduct(dir, (hull->positions+(i_best*3)));
+	for(;;)
+	{
+		i_next = i_best;
+		for(k = hull->adj_first[i_best]; k < hull->adj_first[i_best+1]; k++)
+		{
+			d = vDotProduct(dir, (hull->positions+(hull->adj[k]*3)));
+			if(d < best)
+			{
+				best = d;
+				i_next = hull->adj[k];
+			}
+		}
+		if(i_next == i_best)
+			break;
+		i_best = i_next;
+	}
+	*min_dot = best;
+
+	return i_best;
+}
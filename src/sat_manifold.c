@@ -0,0 +1,146 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+
+/*
+Contact manifolds kept between steps. Every contact remembers the hull features
+that made it and where it is on each of the two bodies. While the separating axis
+of a pair stays on the same reference face, a manifold that holds every vertex of
+the incident face is refreshed from those points instead of clipping the faces
+again. Otherwise the contacts are made again and ManifoldUpdate() carries the
+state of the ones with the same features forward.
+*/
+
+static void BodyToLocal(struct box_struct * box, float * point, float * local_point);
+static void BodyToWorld(struct box_struct * box, float * local_point, float * point);
+static int ContactIdEqual(struct contact_id_struct * a, struct contact_id_struct * b);
+
+//saves where the contact is on each body. 'pointA' is on boxA and 'pointB' on boxB
+void ContactSetLocalPoints(struct contact_info_struct * contact, struct box_struct * boxA, struct box_struct * boxB, float * pointA, float * pointB)
+{
+	BodyToLocal(boxA, pointA, contact->local_point[0]);
+	BodyToLocal(boxB, pointB, contact->local_point[1]);
+}
+
+/*
+Moves the contacts of 'manifold' with the bodies. d_min is the separating axis
+search of this step.
+returns 1 if the contacts are still valid, 0 if they have to be made again because
+the axis moved to another feature or a contact separated or drifted.
+*/
+int ManifoldRefresh(struct contact_manifold_struct * manifold, struct d_min_struct * d_min, struct box_struct * boxA, struct box_struct * boxB)
+{
+	struct contact_info_struct * contact;
+	float pointA[3];
+	float pointB[3];
+	float diff[3];
+	float tangent[3];
+	float depth;
+	int feature;
+	int i;
+
+	if(manifold->num_contacts == 0 || manifold->is_complete == 0 || d_min->source != 0)
+		return 0;
+	feature = (d_min->i_hull[0] == 0) ? SAT_FEATURE_FACE_A : SAT_FEATURE_FACE_B;
+	if(manifold->contacts[0].id.feature != feature || manifold->contacts[0].id.index[0] != d_min->i_face)
+		return 0;
+
+	//check all contacts before changing any of them
+	for(i = 0; i < manifold->num_contacts; i++)
+	{
+		contact = manifold->contacts+i;
+		BodyToWorld(boxA, contact->local_point[0], pointA);
+		BodyToWorld(boxB, contact->local_point[1], pointB);
+
+		//normal points from B to A, so B's point is past A's when they overlap
+		vSubtract(diff, pointB, pointA);
+		depth = vDotProduct(diff, d_min->s_min);
+		if(depth < 0.0f)
+			return 0;
+		tangent[0] = diff[0] - (d_min->s_min[0]*depth);
+		tangent[1] = diff[1] - (d_min->s_min[1]*depth);
+		tangent[2] = diff[2] - (d_min->s_min[2]*depth);
+		if(vDotProduct(tangent, tangent) > (SAT_CONTACT_DRIFT*SAT_CONTACT_DRIFT))
+			return 0;
+	}
+
+	for(i = 0; i < manifold->num_contacts; i++)
+	{
+		contact = manifold->contacts+i;
+		BodyToWorld(boxA, contact->local_point[0], pointA);
+		BodyToWorld(boxB, contact->local_point[1], pointB);
+		vSubtract(diff, pointB, pointA);
+
+		//face contacts are on the reference face
+		if(feature == SAT_FEATURE_FACE_A)
+			memcpy(contact->point, pointA, 3*sizeof(float));
+		else
+			memcpy(contact->point, pointB, 3*sizeof(float));
+		memcpy(contact->normal, d_min->s_min, 3*sizeof(float));
+		contact->penetration = vDotProduct(diff, d_min->s_min);
+		contact->age += 1;
+	}
+
+	return 1;
+}
+
+//replaces the contacts of 'manifold' by 'new_manifold'. contacts with the same features as an old one keep its state.
+void ManifoldUpdate(struct contact_manifold_struct * manifold, struct contact_manifold_struct * new_manifold)
+{
+	struct contact_info_struct * contact;
+	int i;
+	int j;
+
+	for(i = 0; i < new_manifold->num_contacts; i++)
+	{
+		contact = new_manifold->contacts+i;
+		contact->age = 0;
+		contact->normal_impulse = 0.0f;
+		for(j = 0; j < manifold->num_contacts; j++)
+		{
+			if(ContactIdEqual(&(contact->id), &(manifold->contacts[j].id)) == 1)
+			{
+				contact->age = manifold->contacts[j].age + 1;
+				contact->normal_impulse = manifold->contacts[j].normal_impulse;
+				break;
+			}
+		}
+	}
+	memcpy(manifold, new_manifold, sizeof(struct contact_manifold_struct));
+}
+
+//the columns of the orientation are the body's axes
+static void BodyToLocal(struct box_struct * box, float * point, float * local_point)
+{
+	float diff[3];
+	int k;
+
+	vSubtract(diff, point, box->pos);
+	for(k = 0; k < 3; k++)
+	{
+		local_point[k] = vDotProduct(diff, (box->orientation+(k*3)));
+	}
+}
+
+static void BodyToWorld(struct box_struct * box, float * local_point, float * point)
+{
+	memcpy(point, local_point, 3*sizeof(float));
+	mmTransformVec3(box->orientation, point);
+	point[0] += box->pos[0];
+	point[1] += box->pos[1];
+	point[2] += box->pos[2];
+}
+
+static int ContactIdEqual(struct contact_id_struct * a, struct contact_id_struct * b)
+{
+	if(a->feature != b->feature)
+		return 0;
+	if(a->index[0] != b->index[0] || a->index[1] != b->index[1] || a->index[2] != b->index[2])
+		return 0;
+
+	return 1;
+}
@@ -0,0 +1,228 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+#include "sat_trace.h"
+
+/*
+Box-box narrowphase. Uses the 15 axis OBB test (3 face axes of each box and the 9
+cross products of their edges) on the box centers, half extents and orientations
+instead of the support queries of the generic hull test.
+The result is written into the same d_min_struct fields as FindSeparatingAxis():
+face axes are mapped to the hull's face indices through hull->box_face and edge axes
+to the pair of supporting edges, so CreateFaceContact() and CreateEdgeContact()
+work on the output unchanged.
+*/
+
+static int FindBoxEdge(struct box_struct * box, float * dir, float * s_vec3, int find_max);
+
+//boxA and boxB must have hull->is_box set. returns 1 if a separating axis was found.
+int FindSeparatingAxisBox(struct box_struct * boxA, struct box_struct * boxB, struct d_min_struct * d_min, struct sat_cache_struct * cache)
+{
+	float * uA[3];	//world axes of the boxes, columns of the orientation matrices
+	float * uB[3];
+	float * hA;
+	float * hB;
+	int (*faceA)[2];	//box_face of the hulls
+	int (*faceB)[2];
+	float R[3][3];	//R[i][j] = uA[i] . uB[j]
+	float absR[3][3];
+	float t_world[3];	//from A's center to B's center
+	float t[3];		//t_world in A's frame
+	float tB[3];	//t_world in B's frame
+	float face_sep[6];
+	float face_axis[6][3];
+	float axis[3];
+	float dist;
+	float len;
+	float ra;
+	float rb;
+	float sep;
+	int is_face[6];
+	int is_edge_initialized=0;
+	int i_axis[2]={0, 0};	//axes of A and B that make the best edge axis
+	int face;
+	int i;
+	int j;
+	int i1;
+	int i2;
+	int j1;
+	int j2;
+	int k;
+	int r;
+
+	memset(d_min, 0, sizeof(struct d_min_struct));
+	hA = boxA->hull->half_extents;
+	hB = boxB->hull->half_extents;
+	faceA = boxA->hull->box_face;
+	faceB = boxB->hull->box_face;
+	for(i = 0; i < 3; i++)
+	{
+		uA[i] = boxA->orientation+(i*3);
+		uB[i] = boxB->orientation+(i*3);
+	}
+	vSubtract(t_world, boxB->pos, boxA->pos);
+	for(i = 0; i < 3; i++)
+	{
+		t[i] = vDotProduct(t_world, uA[i]);
+		tB[i] = vDotProduct(t_world, uB[i]);
+		for(j = 0; j < 3; j++)
+		{
+			R[i][j] = vDotProduct(uA[i], uB[j]);
+			absR[i][j] = fabsf(R[i][j]);
+		}
+	}
+
+	//Face axes of A. Only the face of each axis that looks toward B can give the max,
+	//on a tie both faces do and the one with the lower index is taken.
+	memset(is_face, 0, sizeof(is_face));
+	for(i = 0; i < 3; i++)
+	{
+		rb = (hB[0]*absR[i][0]) + (hB[1]*absR[i][1]) + (hB[2]*absR[i][2]);
+		if(t[i] > 0.0f || (t[i] == 0.0f && faceA[i][0] < faceA[i][1]))
+			k = -1; //s points into A, opposite of the face normal
+		else
+			k = 1;
+		face = (k == -1) ? faceA[i][0] : faceA[i][1];
+		is_face[face] = 1;
+		face_sep[face] = fabsf(t[i]) - (hA[i] + rb);
+		face_axis[face][0] = (float)k*uA[i][0];
+		face_axis[face][1] = (float)k*uA[i][1];
+		face_axis[face][2] = (float)k*uA[i][2];
+	}
+	//visit them in face order so ties resolve like FindSeparatingAxis()
+	for(face = 0; face < 6; face++)
+	{
+		if(is_face[face] == 0)
+			continue;
+		if(d_min->is_initialized == 0 || face_sep[face] > d_min->d_min)
+		{
+			d_min->d_min = face_sep[face];
+			memcpy(d_min->s_min, face_axis[face], 3*sizeof(float));
+			d_min->i_face = face;
+			d_min->i_hull[0] = 0; //A
+			d_min->i_hull[1] = 1; //B
+			d_min->is_initialized = 1;
+		}
+	}
+
+	//Face axes of B. The face that looks toward A is the + face when A is on the + side.
+	memset(is_face, 0, sizeof(is_face));
+	for(j = 0; j < 3; j++)
+	{
+		ra = (hA[0]*absR[0][j]) + (hA[1]*absR[1][j]) + (hA[2]*absR[2][j]);
+		if(tB[j] < 0.0f || (tB[j] == 0.0f && faceB[j][0] < faceB[j][1]))
+			k = 1; //s is the face normal of B
+		else
+			k = -1;
+		face = (k == 1) ? faceB[j][0] : faceB[j][1];
+		is_face[face] = 1;
+		face_sep[face] = fabsf(tB[j]) - (ra + hB[j]);
+		face_axis[face][0] = (float)k*uB[j][0];
+		face_axis[face][1] = (float)k*uB[j][1];
+		face_axis[face][2] = (float)k*uB[j][2];
+	}
+	for(face = 0; face < 6; face++)
+	{
+		if(is_face[face] == 0)
+			continue;
+		if(face_sep[face] > d_min->d_min)
+		{
+			d_min->d_min = face_sep[face];
+			memcpy(d_min->s_min, face_axis[face], 3*sizeof(float));
+			d_min->i_face = face;
+			d_min->i_hull[0] = 1; //B
+			d_min->i_hull[1] = 0; //A
+		}
+	}
+	d_min->d_min_faces = d_min->d_min;
+	memcpy(d_min->s_min_faces, d_min->s_min, 3*sizeof(float));
+
+	//Edge axes uA[i] x uB[j]. Near parallel edges are skipped like in FindSeparatingAxis().
+	d_min->d_min_edges = -FLT_MAX;
+	for(i = 0; i < 3; i++)
+	{
+		i1 = (i+1)%3;
+		i2 = (i+2)%3;
+		for(j = 0; j < 3; j++)
+		{
+			j1 = (j+1)%3;
+			j2 = (j+2)%3;
+			//the length comes from the cross product itself, 1-R^2 loses too much precision
+			//for near parallel axes
+			vCrossProduct(axis, uA[i], uB[j]);
+			len = vMagnitude(axis);
+			if(len <= 0.001f)
+				continue;
+
+			dist = (t[i2]*R[i1][j]) - (t[i1]*R[i2][j]);
+			ra = (hA[i1]*absR[i2][j]) + (hA[i2]*absR[i1][j]);
+			rb = (hB[j1]*absR[i][j2]) + (hB[j2]*absR[i][j1]);
+			sep = (fabsf(dist) - (ra + rb))/len;
+			if(is_edge_initialized == 1 && sep <= d_min->d_min_edges)
+				continue;
+
+			k = (dist > 0.0f) ? -1 : 1; //s points from B to A
+			axis[0] *= (float)k/len;
+			axis[1] *= (float)k/len;
+			axis[2] *= (float)k/len;
+			d_min->d_min_edges = sep;
+			memcpy(d_min->s_min_edges, axis, 3*sizeof(float));
+			i_axis[0] = i;
+			i_axis[1] = j;
+			is_edge_initialized = 1;
+		}
+	}
+	//the supporting edges are only looked up for the best edge axis
+	if(is_edge_initialized == 1)
+	{
+		d_min->i_edge[0] = FindBoxEdge(boxA, uA[i_axis[0]], d_min->s_min_edges, 0);
+		d_min->i_edge[1] = FindBoxEdge(boxB, uB[i_axis[1]], d_min->s_min_edges, 1);
+	}
+
+	r = SelectSeparatingAxis(d_min, cache);
+
+	SAT_VERBOSE("box separating axis: r=%d d_min=%f source=%d", r, d_min->d_min, d_min->source);
+
+	return r;
+}
+
+//returns the edge of the box parallel to 'dir' with the smallest (find_max=0) or largest (find_max=1) projection on s_vec3
+static int FindBoxEdge(struct box_struct * box, float * dir, float * s_vec3, int find_max)
+{
+	struct box_collision_struct * hull;
+	struct edge_struct * edge;
+	float local_dir[3];
+	float local_s[3];
+	float best=0.0f;
+	float d;
+	int i_best=0;
+	int is_initialized=0;
+	int i;
+
+	//compare in the hull's frame, the body's position moves every edge by the same amount
+	hull = box->hull;
+	HullToLocalDir(box, dir, local_dir);
+	HullToLocalDir(box, s_vec3, local_s);
+	for(i = 0; i < hull->num_edges; i++)
+	{
+		edge = hull->edges+i;
+		if(fabsf(vDotProduct(edge->normal, local_dir)) < 0.5f)
+			continue;
+		d = vDotProduct(local_s, (hull->positions+(edge->i_vertices[0]*3))) + vDotProduct(local_s, (hull->positions+(edge->i_vertices[1]*3)));
+		if(find_max == 1)
+			d = -d;
+		if(is_initialized == 0 || d < best)
+		{
+			best = d;
+			i_best = i;
+			is_initialized = 1;
+		}
+	}
+
+	return i_best;
+}
@@ -0,0 +1,202 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "sat.h"
+
+/*
+Per pair state kept between steps. Entries are found by hashing the two body
+pointers and probing linearly. PairCacheEndStep() only advances the step, an entry
+that wasn't used during a step is stale from then on:
+-if its pair comes back PairCacheGet() resets it in place, as if it was new.
+-stale entries keep their slot until the table fills up. PairCacheCompact() then
+ rebuilds the table from the live entries only, doubling it if they still take
+ more than a quarter of it.
+So the table is only walked when it is full, not every step.
+*/
+
+static int PairCacheCompact(struct pair_cache_struct * cache, int num_new_entries);
+static int IsEntryLive(struct pair_cache_struct * cache, struct pair_cache_entry_struct * entry);
+static unsigned int HashBodyPair(struct box_struct * bodyA, struct box_struct * bodyB);
+
+//'max_entries' is rounded up to a power of 2
+int PairCacheInit(struct pair_cache_struct * cache, int max_entries)
+{
+	int size;
+
+	memset(cache, 0, sizeof(struct pair_cache_struct));
+	size = 16;
+	while(size < max_entries)
+	{
+		size *= 2;
+	}
+
+	cache->entries = (struct pair_cache_entry_struct*)calloc(size, sizeof(struct pair_cache_entry_struct));
+	if(cache->entries == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	cache->max_entries = size;
+	cache->step = 1;
+
+	return 1;
+}
+
+void PairCacheFree(struct pair_cache_struct * cache)
+{
+	free(cache->entries);
+	memset(cache, 0, sizeof(struct pair_cache_struct));
+}
+
+/*
+Returns the entry of the pair (bodyA, bodyB), creating a zero'd one if the pair
+wasn't cached. The order of the bodies matters, (A, B) and (B, A) are different
+entries since features are stored per hull.
+returns 0 on failure.
+*/
+struct pair_cache_entry_struct * PairCacheGet(struct pair_cache_struct * cache, struct box_struct * bodyA, struct box_struct * bodyB)
+{
+	struct pair_cache_entry_struct * entry;
+	unsigned int mask;
+	unsigned int i;
+	int r;
+
+	//keep the load factor under 1/2
+	if((cache->num_entries+1)*2 > cache->max_entries)
+	{
+		r = PairCacheCompact(cache, 1);
+		if(r == 0)
+			return 0;
+	}
+
+	mask = (unsigned int)(cache->max_entries-1);
+	i = HashBodyPair(bodyA, bodyB) & mask;
+	for(;;)
+	{
+		entry = cache->entries+i;
+		if(entry->body[0] == 0)
+		{
+			memset(entry, 0, sizeof(struct pair_cache_entry_struct));
+			entry->body[0] = bodyA;
+			entry->body[1] = bodyB;
+			cache->num_entries += 1;
+			break;
+		}
+		if(entry->body[0] == bodyA && entry->body[1] == bodyB)
+		{
+			//the pair left for a step, its state is out of date
+			if(IsEntryLive(cache, entry) == 0)
+			{
+				memset(entry, 0, sizeof(struct pair_cache_entry_struct));
+				entry->body[0] = bodyA;
+				entry->body[1] = bodyB;
+			}
+			break;
+		}
+		i = (i+1) & mask;
+	}
+	entry->last_step = cache->step;
+
+	return entry;
+}
+
+/*
+Makes room so 'num_new_entries' pairs can be added without compacting the table
+again. Entries don't move until the next PairCacheReserve(), so pointers to them
+can be kept for the rest of the step.
+returns 0 on failure.
+*/
+int PairCacheReserve(struct pair_cache_struct * cache, int num_new_entries)
+{
+	int r;
+
+	if((cache->num_entries+num_new_entries)*2 > cache->max_entries)
+	{
+		r = PairCacheCompact(cache, num_new_entries);
+		if(r == 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+//the pairs that weren't used this step become stale
+void PairCacheEndStep(struct pair_cache_struct * cache)
+{
+	cache->step += 1;
+}
+
+/*
+Rebuilds the table from the live entries, leaving room for 'num_new_entries' more
+with the load factor under 1/4, so the next compaction is far off.
+returns 0 on failure.
+*/
+static int PairCacheCompact(struct pair_cache_struct * cache, int num_new_entries)
+{
+	struct pair_cache_entry_struct * new_entries;
+	unsigned int mask;
+	unsigned int j;
+	int num_live=0;
+	int new_max;
+	int i;
+
+	for(i = 0; i < cache->max_entries; i++)
+	{
+		if(IsEntryLive(cache, (cache->entries+i)) == 1)
+			num_live += 1;
+	}
+	new_max = cache->max_entries;
+	while((num_live+num_new_entries)*4 > new_max)
+	{
+		new_max *= 2;
+	}
+
+	new_entries = (struct pair_cache_entry_struct*)calloc(new_max, sizeof(struct pair_cache_entry_struct));
+	if(new_entries == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	mask = (unsigned int)(new_max-1);
+	for(i = 0; i < cache->max_entries; i++)
+	{
+		if(IsEntryLive(cache, (cache->entries+i)) == 0)
+			continue;
+		j = HashBodyPair(cache->entries[i].body[0], cache->entries[i].body[1]) & mask;
+		while(new_entries[j].body[0] != 0)
+		{
+			j = (j+1) & mask;
+		}
+		new_entries[j] = cache->entries[i];
+	}
+	free(cache->entries);
+	cache->entries = new_entries;
+	cache->max_entries = new_max;
+	cache->num_entries = num_live;
+
+	return 1;
+}
+
+//returns 1 if the entry was used this step or the last one
+static int IsEntryLive(struct pair_cache_struct * cache, struct pair_cache_entry_struct * entry)
+{
+	if(entry->body[0] == 0)
+		return 0;
+	if((entry->last_step+1) < cache->step)
+		return 0;
+
+	return 1;
+}
+
+static unsigned int HashBodyPair(struct box_struct * bodyA, struct box_struct * bodyB)
+{
+	uint64_t h;
+
+	h = ((uint64_t)(uintptr_t)bodyA)*0x9E3779B97F4A7C15ull;
+	h ^= ((uint64_t)(uintptr_t)bodyB) + 0x7F4A7C15ull + (h << 6) + (h >> 2);
+	h *= 0xBF58476D1CE4E5B9ull;
+
+	return (unsigned int)(h >> 32);
+}
@@ -0,0 +1,1036 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <time.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+
+/*
+Builds a hull from a point cloud. The points are welded, quickhull makes a triangle
+mesh of the hull, then triangles that lie in the same plane are merged into one face
+and the vertices left in the middle of a face or an edge are dropped. What comes out
+is a hull like InitHull() makes (faces, edges with their two faces, axis groups, arcs,
+adjacency, half edges and soa) except that faces can have any number of vertices. A
+point cloud of an axis aligned box centered on the origin gets is_box like InitHull()'s.
+
+Triangles of the quickhull mesh are counter clockwise seen from outside, neighbor[k]
+is the triangle on the other side of the edge v[k] -> v[k+1].
+*/
+
+#define QH_MAX_BLOCKS 16	//scratch arrays of one build
+
+struct qh_face_struct
+{
+	int v[3];
+	int neighbor[3];
+	float normal[3];
+	float offset;		//dot(normal, x) for any x on the plane
+	int first_outside;	//first point of the outside set, -1 if it is empty
+	int visit;			//last qh_struct.visit the face was tested in
+	int is_visible;
+	int is_deleted;
+	int group;			//merged face it belongs to
+};
+
+struct qh_horizon_struct
+{
+	int v[2];	//edge of a visible face
+	int face;	//the face on the other side, which stays
+};
+
+//one boundary edge of a merged face
+struct qh_half_edge_struct
+{
+	int v[2];
+	int face;
+};
+
+struct qh_struct
+{
+	float * points;
+	int num_points;
+	int * point_next;	//outside sets are linked lists through this
+	struct qh_face_struct * faces;
+	int num_faces;
+	int max_faces;
+	int * stack;
+	int max_stack;
+	int * visible;
+	int num_visible;
+	int max_visible;
+	struct qh_horizon_struct * horizon;
+	int num_horizon;
+	int max_horizon;
+	float eps;			//points closer than this to a plane are on it
+	float merge_dist;	//triangles with all vertices this close to a face's plane join the face
+	int visit;
+	void * blocks[QH_MAX_BLOCKS];	//from QhAlloc()
+	int num_blocks;
+	int mem_bytes;
+	int peak_bytes;
+};
+
+static int QhWeld(struct qh_struct * qh, float * points, int num_points, float tol);
+static int QhInitSimplex(struct qh_struct * qh);
+static int QhAddFace(struct qh_struct * qh, int a, int b, int c);
+static float QhDist(struct qh_struct * qh, int i_face, int i_point);
+static void QhAssignPoints(struct qh_struct * qh, int first_point, int first_face, int num_faces);
+static int QhAddPoint(struct qh_struct * qh, int i_face, int i_point);
+static int QhMakeHull(struct qh_struct * qh, struct box_collision_struct * phull, struct hull_build_stats_struct * stats);
+static int QhGrow(struct qh_struct * qh, void ** array, int * max, int needed, int size);
+static void * QhAlloc(struct qh_struct * qh, int size);
+static void QhFree(struct qh_struct * qh);
+static int CompareX(const void * a, const void * b);
+static int CompareHalfEdge(const void * a, const void * b);
+
+/*
+'points' is an array of num_points vec3's in the frame of the bodies that will use the
+hull. stats can be 0.
+returns 1 on success, 0 if the points are flat or the build failed.
+*/
+int BuildHull(float * points, int num_points, struct box_collision_struct * phull, struct hull_build_stats_struct * stats)
+{
+	struct hull_build_stats_struct local_stats;
+	struct qh_struct qh;
+	struct timespec start;
+	struct timespec end;
+	float size=0.0f;
+	float max_dist;
+	float dist;
+	int i_face;
+	int i_point;
+	int i_far;
+	int i;
+	int k;
+	int r;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	memset(phull, 0, sizeof(struct box_collision_struct));
+	memset(&qh, 0, sizeof(struct qh_struct));
+	if(stats == 0)
+		stats = &local_stats;
+	memset(stats, 0, sizeof(struct hull_build_stats_struct));
+	stats->num_input_points = num_points;
+	if(num_points < 4)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+
+	//tolerances scale with the size of the cloud
+	for(k = 0; k < 3; k++)
+	{
+		dist = 0.0f;
+		for(i = 0; i < num_points; i++)
+		{
+			if(fabsf(points[(i*3)+k]) > dist)
+				dist = fabsf(points[(i*3)+k]);
+		}
+		size += dist;
+	}
+	qh.eps = 0.00001f*size;
+	qh.merge_dist = 0.0001f*size;
+
+	r = QhWeld(&qh, points, num_points, qh.merge_dist);
+	if(r == 0)
+	{
+		QhFree(&qh);
+		return 0;
+	}
+	stats->num_welded = num_points - qh.num_points;
+
+	r = QhInitSimplex(&qh);
+	if(r == 0)
+	{
+		QhFree(&qh);
+		return 0;
+	}
+
+	//add the farthest point of each face's outside set until every set is empty
+	i_face = 0;
+	while(i_face < qh.num_faces)
+	{
+		if(qh.faces[i_face].is_deleted == 1 || qh.faces[i_face].first_outside == -1)
+		{
+			i_face += 1;
+			continue;
+		}
+		i_far = qh.faces[i_face].first_outside;
+		max_dist = QhDist(&qh, i_face, i_far);
+		for(i_point = qh.point_next[i_far]; i_point != -1; i_point = qh.point_next[i_point])
+		{
+			dist = QhDist(&qh, i_face, i_point);
+			if(dist > max_dist)
+			{
+				max_dist = dist;
+				i_far = i_point;
+			}
+		}
+		r = QhAddPoint(&qh, i_face, i_far);
+		if(r == 0)
+		{
+			QhFree(&qh);
+			return 0;
+		}
+	}
+
+	r = QhMakeHull(&qh, phull, stats);
+	QhFree(&qh);
+	if(r == 0)
+	{
+		FreeHull(phull);
+		return 0;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	stats->build_ms = ((double)(end.tv_sec - start.tv_sec)*1000.0) + ((double)(end.tv_nsec - start.tv_nsec)/1000000.0);
+	stats->temp_bytes = qh.peak_bytes;
+	stats->hull_bytes = HullMemorySize(phull);
+
+	return 1;
+}
+
+//copies the points into qh->points, dropping the ones closer than tol to a point already kept
+static int QhWeld(struct qh_struct * qh, float * points, int num_points, float tol)
+{
+	float * sorted;
+	float d[3];
+	int is_duplicate;
+	int i;
+	int j;
+
+	sorted = (float*)malloc(num_points*3*sizeof(float));
+	qh->points = (float*)QhAlloc(qh, num_points*3*sizeof(float));
+	qh->point_next = (int*)QhAlloc(qh, num_points*sizeof(int));
+	if(sorted == 0 || qh->points == 0 || qh->point_next == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		free(sorted);
+		return 0;
+	}
+
+	//sorted by x only the kept points within tol in x have to be compared
+	memcpy(sorted, points, num_points*3*sizeof(float));
+	qsort(sorted, num_points, 3*sizeof(float), CompareX);
+	qh->num_points = 0;
+	for(i = 0; i < num_points; i++)
+	{
+		is_duplicate = 0;
+		for(j = qh->num_points-1; j >= 0; j--)
+		{
+			if(qh->points[(j*3)] < (sorted[(i*3)]-tol))
+				break;
+			vSubtract(d, (sorted+(i*3)), (qh->points+(j*3)));
+			if(vDotProduct(d, d) <= (tol*tol))
+			{
+				is_duplicate = 1;
+				break;
+			}
+		}
+		if(is_duplicate == 1)
+			continue;
+		memcpy((qh->points+(qh->num_points*3)), (sorted+(i*3)), 3*sizeof(float));
+		qh->num_points += 1;
+	}
+	free(sorted);
+
+	return 1;
+}
+
+//makes the first tetrahedron from extreme points of the cloud and gives every other point to it
+static int QhInitSimplex(struct qh_struct * qh)
+{
+	struct qh_face_struct * face;
+	struct qh_face_struct * other;
+	float * p;
+	float extreme_dist[6];
+	float line[3];
+	float d[3];
+	float c[3];
+	float dist;
+	float max_dist;
+	int extreme[6];
+	int simplex[4];
+	int i;
+	int j;
+	int k;
+	int l;
+
+	for(k = 0; k < 6; k++)
+	{
+		extreme[k] = 0;
+		extreme_dist[k] = (k%2 == 0) ? qh->points[(k/2)] : -qh->points[(k/2)];
+	}
+	for(i = 1; i < qh->num_points; i++)
+	{
+		for(k = 0; k < 6; k++)
+		{
+			dist = (k%2 == 0) ? qh->points[(i*3)+(k/2)] : -qh->points[(i*3)+(k/2)];
+			if(dist < extreme_dist[k])
+			{
+				extreme_dist[k] = dist;
+				extreme[k] = i;
+			}
+		}
+	}
+
+	//the two extreme points farthest apart
+	max_dist = -1.0f;
+	for(i = 0; i < 6; i++)
+	{
+		for(j = i+1; j < 6; j++)
+		{
+			vSubtract(d, (qh->points+(extreme[i]*3)), (qh->points+(extreme[j]*3)));
+			dist = vDotProduct(d, d);
+			if(dist > max_dist)
+			{
+				max_dist = dist;
+				simplex[0] = extreme[i];
+				simplex[1] = extreme[j];
+			}
+		}
+	}
+
+	//the point farthest from their line
+	vSubtract(line, (qh->points+(simplex[1]*3)), (qh->points+(simplex[0]*3)));
+	vNormalize(line);
+	max_dist = -1.0f;
+	for(i = 0; i < qh->num_points; i++)
+	{
+		vSubtract(d, (qh->points+(i*3)), (qh->points+(simplex[0]*3)));
+		vCrossProduct(c, d, line);
+		dist = vDotProduct(c, c);
+		if(dist > max_dist)
+		{
+			max_dist = dist;
+			simplex[2] = i;
+		}
+	}
+	if(max_dist <= (qh->eps*qh->eps))
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+
+	//the point farthest from their plane
+	vSubtract(d, (qh->points+(simplex[2]*3)), (qh->points+(simplex[0]*3)));
+	vCrossProduct(c, line, d);
+	vNormalize(c);
+	max_dist = -1.0f;
+	for(i = 0; i < qh->num_points; i++)
+	{
+		vSubtract(d, (qh->points+(i*3)), (qh->points+(simplex[0]*3)));
+		dist = fabsf(vDotProduct(c, d));
+		if(dist > max_dist)
+		{
+			max_dist = dist;
+			simplex[3] = i;
+		}
+	}
+	if(max_dist <= qh->eps)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+
+	//each face is wound so the vertex it leaves out is behind it
+	for(k = 0; k < 4; k++)
+	{
+		i = QhAddFace(qh, simplex[(k+1)%4], simplex[(k+2)%4], simplex[(k+3)%4]);
+		if(i == -1)
+			return 0;
+		face = qh->faces+i;
+		p = qh->points+(simplex[k]*3);
+		if((vDotProduct(face->normal, p) - face->offset) > 0.0f)
+		{
+			l = face->v[1];
+			face->v[1] = face->v[2];
+			face->v[2] = l;
+			face->normal[0] = -face->normal[0];
+			face->normal[1] = -face->normal[1];
+			face->normal[2] = -face->normal[2];
+			face->offset = -face->offset;
+		}
+	}
+	for(i = 0; i < 4; i++)
+	{
+		face = qh->faces+i;
+		for(k = 0; k < 3; k++)
+		{
+			for(j = 0; j < 4; j++)
+			{
+				other = qh->faces+j;
+				for(l = 0; l < 3; l++)
+				{
+					if(other->v[l] == face->v[(k+1)%3] && other->v[(l+1)%3] == face->v[k])
+						face->neighbor[k] = j;
+				}
+			}
+		}
+	}
+
+	//chain the points that aren't in the simplex, then hand them out
+	l = -1;
+	for(i = qh->num_points-1; i >= 0; i--)
+	{
+		qh->point_next[i] = -1;
+		if(i == simplex[0] || i == simplex[1] || i == simplex[2] || i == simplex[3])
+			continue;
+		qh->point_next[i] = l;
+		l = i;
+	}
+	QhAssignPoints(qh, l, 0, 4);
+
+	return 1;
+}
+
+//returns the index of the new face, -1 on failure. neighbors are left for the caller.
+static int QhAddFace(struct qh_struct * qh, int a, int b, int c)
+{
+	struct qh_face_struct * face;
+	float ab[3];
+	float ac[3];
+	float mag;
+	int r;
+
+	r = QhGrow(qh, (void**)&qh->faces, &qh->max_faces, qh->num_faces+1, sizeof(struct qh_face_struct));
+	if(r == 0)
+		return -1;
+	face = qh->faces+qh->num_faces;
+	memset(face, 0, sizeof(struct qh_face_struct));
+	face->v[0] = a;
+	face->v[1] = b;
+	face->v[2] = c;
+	face->first_outside = -1;
+	face->group = -1;
+	vSubtract(ab, (qh->points+(b*3)), (qh->points+(a*3)));
+	vSubtract(ac, (qh->points+(c*3)), (qh->points+(a*3)));
+	vCrossProduct(face->normal, ab, ac);
+	mag = vMagnitude(face->normal);
+	if(mag > 0.0f)
+	{
+		face->normal[0] /= mag;
+		face->normal[1] /= mag;
+		face->normal[2] /= mag;
+	}
+	face->offset = vDotProduct(face->normal, (qh->points+(a*3)));
+	qh->num_faces += 1;
+
+	return (qh->num_faces-1);
+}
+
+static float QhDist(struct qh_struct * qh, int i_face, int i_point)
+{
+	return (vDotProduct(qh->faces[i_face].normal, (qh->points+(i_point*3))) - qh->faces[i_face].offset);
+}
+
+//moves each point of the list starting at first_point to the outside set of the face it is farthest above, or drops it
+static void QhAssignPoints(struct qh_struct * qh, int first_point, int first_face, int num_faces)
+{
+	float max_dist;
+	float dist;
+	int i_point;
+	int i_next;
+	int i_best;
+	int i;
+
+	for(i_point = first_point; i_point != -1; i_point = i_next)
+	{
+		i_next = qh->point_next[i_point];
+		i_best = -1;
+		max_dist = qh->eps;
+		for(i = first_face; i < (first_face+num_faces); i++)
+		{
+			dist = QhDist(qh, i, i_point);
+			if(dist > max_dist)
+			{
+				max_dist = dist;
+				i_best = i;
+			}
+		}
+		if(i_best == -1)
+		{
+			qh->point_next[i_point] = -1;
+			continue;
+		}
+		qh->point_next[i_point] = qh->faces[i_best].first_outside;
+		qh->faces[i_best].first_outside = i_point;
+	}
+}
+
+/*
+Replaces the faces i_point sees with a cone of faces from i_point to the edge of the
+visible region. If that edge isn't one loop the point is dropped instead.
+returns 0 on failure.
+*/
+static int QhAddPoint(struct qh_struct * qh, int i_face, int i_point)
+{
+	struct qh_face_struct * face;
+	struct qh_face_struct * other;
+	struct qh_horizon_struct temp;
+	int num_stack;
+	int first_point;
+	int last_point;
+	int first_new;
+	int num_new;
+	int i_other;
+	int i;
+	int j;
+	int k;
+	int r;
+
+	//depth first search of the visible faces, collecting the horizon on the way
+	qh->visit += 1;
+	qh->num_visible = 0;
+	qh->num_horizon = 0;
+	qh->faces[i_face].visit = qh->visit;
+	qh->faces[i_face].is_visible = 1;
+	r = QhGrow(qh, (void**)&qh->stack, &qh->max_stack, 1, sizeof(int));
+	if(r == 0)
+		return 0;
+	qh->stack[0] = i_face;
+	num_stack = 1;
+	while(num_stack > 0)
+	{
+		num_stack -= 1;
+		i = qh->stack[num_stack];
+		r = QhGrow(qh, (void**)&qh->visible, &qh->max_visible, qh->num_visible+1, sizeof(int));
+		if(r == 0)
+			return 0;
+		qh->visible[qh->num_visible] = i;
+		qh->num_visible += 1;
+		for(k = 0; k < 3; k++)
+		{
+			i_other = qh->faces[i].neighbor[k];
+			other = qh->faces+i_other;
+			if(other->visit != qh->visit)
+			{
+				other->visit = qh->visit;
+				other->is_visible = (QhDist(qh, i_other, i_point) > qh->eps) ? 1 : 0;
+				if(other->is_visible == 1)
+				{
+					r = QhGrow(qh, (void**)&qh->stack, &qh->max_stack, num_stack+1, sizeof(int));
+					if(r == 0)
+						return 0;
+					qh->stack[num_stack] = i_other;
+					num_stack += 1;
+				}
+			}
+			if(other->is_visible == 0)
+			{
+				r = QhGrow(qh, (void**)&qh->horizon, &qh->max_horizon, qh->num_horizon+1, sizeof(struct qh_horizon_struct));
+				if(r == 0)
+					return 0;
+				qh->horizon[qh->num_horizon].v[0] = qh->faces[i].v[k];
+				qh->horizon[qh->num_horizon].v[1] = qh->faces[i].v[(k+1)%3];
+				qh->horizon[qh->num_horizon].face = i_other;
+				qh->num_horizon += 1;
+			}
+		}
+	}
+
+	//put the horizon edges in order, each one starting where the one before ends
+	for(i = 1; i < qh->num_horizon; i++)
+	{
+		for(j = i; j < qh->num_horizon; j++)
+		{
+			if(qh->horizon[j].v[0] == qh->horizon[i-1].v[1])
+				break;
+		}
+		if(j == qh->num_horizon || qh->horizon[i-1].v[1] == qh->horizon[0].v[0])
+			break;
+		temp = qh->horizon[i];
+		qh->horizon[i] = qh->horizon[j];
+		qh->horizon[j] = temp;
+	}
+	if(i < qh->num_horizon || qh->horizon[qh->num_horizon-1].v[1] != qh->horizon[0].v[0])
+	{
+		//numerically the region isn't a disc. drop the point, the hull stays convex within eps
+		face = qh->faces+i_face;
+		if(face->first_outside == i_point)
+		{
+			face->first_outside = qh->point_next[i_point];
+		}
+		else
+		{
+			for(j = face->first_outside; qh->point_next[j] != i_point; j = qh->point_next[j]);
+			qh->point_next[j] = qh->point_next[i_point];
+		}
+		qh->point_next[i_point] = -1;
+		return 1;
+	}
+
+	//collect the outside sets of the visible faces into one list
+	first_point = -1;
+	last_point = -1;
+	for(i = 0; i < qh->num_visible; i++)
+	{
+		face = qh->faces+qh->visible[i];
+		face->is_deleted = 1;
+		for(j = face->first_outside; j != -1; j = qh->point_next[j])
+		{
+			if(first_point == -1)
+				first_point = j;
+			else
+				qh->point_next[last_point] = j;
+			last_point = j;
+		}
+		face->first_outside = -1;
+	}
+	if(last_point != -1)
+		qh->point_next[last_point] = -1;
+
+	//the cone
+	first_new = qh->num_faces;
+	num_new = qh->num_horizon;
+	for(i = 0; i < num_new; i++)
+	{
+		j = QhAddFace(qh, qh->horizon[i].v[0], qh->horizon[i].v[1], i_point);
+		if(j == -1)
+			return 0;
+		face = qh->faces+j;
+		face->neighbor[0] = qh->horizon[i].face;
+		face->neighbor[1] = first_new + ((i+1)%num_new);
+		face->neighbor[2] = first_new + ((i+num_new-1)%num_new);
+		other = qh->faces+qh->horizon[i].face;
+		for(k = 0; k < 3; k++)
+		{
+			if(other->v[k] == qh->horizon[i].v[1] && other->v[(k+1)%3] == qh->horizon[i].v[0])
+				other->neighbor[k] = j;
+		}
+	}
+
+	//i_point is on the hull now
+	if(first_point == i_point)
+	{
+		first_point = qh->point_next[i_point];
+	}
+	else
+	{
+		for(j = first_point; qh->point_next[j] != i_point; j = qh->point_next[j]);
+		qh->point_next[j] = qh->point_next[i_point];
+	}
+	qh->point_next[i_point] = -1;
+	QhAssignPoints(qh, first_point, first_new, num_new);
+
+	return 1;
+}
+
+/*
+Merges the triangles into faces, drops the vertices that aren't corners and fills in
+phull.
+*/
+static int QhMakeHull(struct qh_struct * qh, struct box_collision_struct * phull, struct hull_build_stats_struct * stats)
+{
+	struct qh_face_struct * face;
+	struct qh_face_struct * seed;
+	struct qh_half_edge_struct * boundary;
+	struct qh_half_edge_struct * half_edges;
+	struct qh_half_edge_struct temp;
+	struct edge_struct * edge;
+	struct face_struct * out_face;
+	float * p0;
+	float * p1;
+	float dist;
+	int * loops;		//vertices of each merged face
+	int * loop_first;
+	int * vert_count;	//faces at each vertex
+	int * vert_map;		//welded point -> hull vertex
+	int * group_first;	//triangles of group m are group_faces[group_first[m]] .. group_faces[group_first[m+1]-1]
+	int * group_faces;
+	int num_loops=0;
+	int num_loop_verts=0;
+	int num_boundary;
+	int num_stack;
+	int num_groups=0;
+	int num_live=0;
+	int num_half_edges;
+	int is_coplanar;
+	int do_prune;
+	int i;
+	int j;
+	int k;
+	int l;
+	int m;
+	int n;
+	int r;
+
+	//flood fill the live triangles into groups, comparing against the plane of the group's first triangle
+	for(i = 0; i < qh->num_faces; i++)
+	{
+		if(qh->faces[i].is_deleted == 1 || qh->faces[i].group != -1)
+			continue;
+		seed = qh->faces+i;
+		seed->group = num_groups;
+		r = QhGrow(qh, (void**)&qh->stack, &qh->max_stack, 1, sizeof(int));
+		if(r == 0)
+			return 0;
+		qh->stack[0] = i;
+		num_stack = 1;
+		while(num_stack > 0)
+		{
+			num_stack -= 1;
+			face = qh->faces+qh->stack[num_stack];
+			num_live += 1;
+			for(k = 0; k < 3; k++)
+			{
+				j = face->neighbor[k];
+				if(qh->faces[j].group != -1 || vDotProduct(qh->faces[j].normal, seed->normal) < 0.9999f)
+					continue;
+				is_coplanar = 1;
+				for(l = 0; l < 3; l++)
+				{
+					dist = vDotProduct(seed->normal, (qh->points+(qh->faces[j].v[l]*3))) - seed->offset;
+					if(fabsf(dist) > qh->merge_dist)
+						is_coplanar = 0;
+				}
+				if(is_coplanar == 0)
+					continue;
+				qh->faces[j].group = num_groups;
+				r = QhGrow(qh, (void**)&qh->stack, &qh->max_stack, num_stack+1, sizeof(int));
+				if(r == 0)
+					return 0;
+				qh->stack[num_stack] = j;
+				num_stack += 1;
+			}
+		}
+		num_groups += 1;
+	}
+	stats->num_hull_triangles = num_live;
+	stats->num_merged = num_live - num_groups;
+
+	//the boundary of each group is the loop of its face. a triangle has 3 boundary edges
+	//and a group's boundary can't be longer than the sum of its triangles'
+	loops = (int*)QhAlloc(qh, 3*num_live*sizeof(int));
+	loop_first = (int*)QhAlloc(qh, (num_live+1)*sizeof(int));
+	boundary = (struct qh_half_edge_struct*)QhAlloc(qh, 3*num_live*sizeof(struct qh_half_edge_struct));
+	vert_count = (int*)QhAlloc(qh, qh->num_points*sizeof(int));
+	vert_map = (int*)QhAlloc(qh, qh->num_points*sizeof(int));
+	group_first = (int*)QhAlloc(qh, (num_groups+1)*sizeof(int));
+	group_faces = (int*)QhAlloc(qh, num_live*sizeof(int));
+	if(loops == 0 || loop_first == 0 || boundary == 0 || vert_count == 0 || vert_map == 0 || group_first == 0 || group_faces == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	//counting sort of the live triangles by group
+	memset(group_first, 0, (num_groups+1)*sizeof(int));
+	for(i = 0; i < qh->num_faces; i++)
+	{
+		if(qh->faces[i].is_deleted == 0)
+			group_first[qh->faces[i].group+1] += 1;
+	}
+	for(m = 0; m < num_groups; m++)
+	{
+		group_first[m+1] += group_first[m];
+	}
+	for(i = 0; i < qh->num_faces; i++)
+	{
+		if(qh->faces[i].is_deleted == 1)
+			continue;
+		m = qh->faces[i].group;
+		group_faces[group_first[m]] = i;
+		group_first[m] += 1;
+	}
+	for(m = num_groups; m > 0; m--)
+	{
+		group_first[m] = group_first[m-1];
+	}
+	group_first[0] = 0;
+
+	for(m = 0; m < num_groups; m++)
+	{
+		num_boundary = 0;
+		for(l = group_first[m]; l < group_first[m+1]; l++)
+		{
+			i = group_faces[l];
+			face = qh->faces+i;
+			for(k = 0; k < 3; k++)
+			{
+				if(qh->faces[face->neighbor[k]].group == m)
+					continue;
+				boundary[num_boundary].v[0] = face->v[k];
+				boundary[num_boundary].v[1] = face->v[(k+1)%3];
+				boundary[num_boundary].face = i;
+				num_boundary += 1;
+			}
+		}
+		for(i = 1; i < num_boundary; i++)
+		{
+			for(j = i; j < num_boundary; j++)
+			{
+				if(boundary[j].v[0] == boundary[i-1].v[1])
+					break;
+			}
+			if(j == num_boundary || boundary[i-1].v[1] == boundary[0].v[0])
+				break;
+			temp = boundary[i];
+			boundary[i] = boundary[j];
+			boundary[j] = temp;
+		}
+		if(i == num_boundary && boundary[num_boundary-1].v[1] == boundary[0].v[0])
+		{
+			loop_first[num_loops] = num_loop_verts;
+			for(i = 0; i < num_boundary; i++)
+			{
+				loops[num_loop_verts] = boundary[i].v[0];
+				num_loop_verts += 1;
+			}
+			num_loops += 1;
+			continue;
+		}
+		//the group touches itself at a vertex, keep its triangles as they are
+		for(l = group_first[m]; l < group_first[m+1]; l++)
+		{
+			face = qh->faces+group_faces[l];
+			loop_first[num_loops] = num_loop_verts;
+			for(k = 0; k < 3; k++)
+			{
+				loops[num_loop_verts] = face->v[k];
+				num_loop_verts += 1;
+			}
+			num_loops += 1;
+			stats->num_merged -= 1;
+		}
+		stats->num_merged += 1;
+	}
+	loop_first[num_loops] = num_loop_verts;
+
+	//a corner of a convex hull is on 3 or more faces. the others are on an edge or
+	//inside a face. drop them unless that would leave a face with less than 3 vertices.
+	memset(vert_count, 0, qh->num_points*sizeof(int));
+	for(i = 0; i < num_loop_verts; i++)
+	{
+		vert_count[loops[i]] += 1;
+	}
+	do_prune = 1;
+	for(m = 0; m < num_loops; m++)
+	{
+		n = 0;
+		for(i = loop_first[m]; i < loop_first[m+1]; i++)
+		{
+			if(vert_count[loops[i]] >= 3)
+				n += 1;
+		}
+		if(n < 3)
+			do_prune = 0;
+	}
+	if(do_prune == 1)
+	{
+		n = 0;
+		for(m = 0; m < num_loops; m++)
+		{
+			j = loop_first[m];
+			loop_first[m] = n;
+			for(i = j; i < loop_first[m+1]; i++)
+			{
+				if(vert_count[loops[i]] < 3)
+					continue;
+				loops[n] = loops[i];
+				n += 1;
+			}
+		}
+		loop_first[num_loops] = n;
+		num_loop_verts = n;
+	}
+
+	//vertices
+	for(i = 0; i < qh->num_points; i++)
+	{
+		vert_map[i] = -1;
+	}
+	for(i = 0; i < num_loop_verts; i++)
+	{
+		if(vert_map[loops[i]] != -1)
+			continue;
+		vert_map[loops[i]] = phull->num_pos;
+		phull->num_pos += 1;
+	}
+	for(i = 0; i < qh->num_points; i++)
+	{
+		if(vert_count[i] > 0 && vert_map[i] == -1)
+			stats->num_removed_verts += 1;
+	}
+	phull->positions = (float*)malloc(phull->num_pos*3*sizeof(float));
+	phull->faces = (struct face_struct*)malloc(num_loops*sizeof(struct face_struct));
+	phull->face_vertices = (int*)malloc(num_loop_verts*sizeof(int));
+	phull->edges = (struct edge_struct*)malloc((num_loop_verts/2)*sizeof(struct edge_struct));
+	half_edges = (struct qh_half_edge_struct*)QhAlloc(qh, num_loop_verts*sizeof(struct qh_half_edge_struct));
+	if(phull->positions == 0 || phull->faces == 0 || phull->face_vertices == 0 || phull->edges == 0 || half_edges == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	for(i = 0; i < qh->num_points; i++)
+	{
+		if(vert_map[i] != -1)
+			memcpy((phull->positions+(vert_map[i]*3)), (qh->points+(i*3)), 3*sizeof(float));
+	}
+
+	//faces, with Newell's normal of the whole loop
+	phull->num_faces = num_loops;
+	phull->num_face_vertices = num_loop_verts;
+	num_half_edges = 0;
+	for(m = 0; m < num_loops; m++)
+	{
+		out_face = phull->faces+m;
+		out_face->i_vertices = phull->face_vertices+loop_first[m];
+		out_face->num_verts = loop_first[m+1] - loop_first[m];
+		memset(out_face->normal, 0, 3*sizeof(float));
+		for(i = 0; i < out_face->num_verts; i++)
+		{
+			out_face->i_vertices[i] = vert_map[loops[loop_first[m]+i]];
+		}
+		for(i = 0; i < out_face->num_verts; i++)
+		{
+			j = (i+1) % out_face->num_verts;
+			p0 = phull->positions+(out_face->i_vertices[i]*3);
+			p1 = phull->positions+(out_face->i_vertices[j]*3);
+			out_face->normal[0] += (p0[1]-p1[1])*(p0[2]+p1[2]);
+			out_face->normal[1] += (p0[2]-p1[2])*(p0[0]+p1[0]);
+			out_face->normal[2] += (p0[0]-p1[0])*(p0[1]+p1[1]);
+			half_edges[num_half_edges].v[0] = out_face->i_vertices[i];
+			half_edges[num_half_edges].v[1] = out_face->i_vertices[j];
+			half_edges[num_half_edges].face = m;
+			num_half_edges += 1;
+		}
+		vNormalize(out_face->normal);
+	}
+
+	//edges. every edge must be in two faces, once in each direction
+	qsort(half_edges, num_half_edges, sizeof(struct qh_half_edge_struct), CompareHalfEdge);
+	phull->num_edges = 0;
+	for(i = 0; i < num_half_edges; i += 2)
+	{
+		if((i+1) >= num_half_edges
+			|| half_edges[i].v[0] != half_edges[i+1].v[1]
+			|| half_edges[i].v[1] != half_edges[i+1].v[0]
+			|| ((i+2) < num_half_edges && CompareHalfEdge(half_edges+i, half_edges+i+2) == 0))
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		edge = phull->edges+phull->num_edges;
+		edge->i_vertices[0] = half_edges[i].v[0];
+		edge->i_vertices[1] = half_edges[i].v[1];
+		edge->i_face[0] = half_edges[i].face;
+		edge->i_face[1] = half_edges[i+1].face;
+		vSubtract(edge->normal, (phull->positions+(edge->i_vertices[1]*3)), (phull->positions+(edge->i_vertices[0]*3)));
+		vNormalize(edge->normal);
+		phull->num_edges += 1;
+	}
+
+	InitHullBoxExtents(phull);
+	r = InitHullAxisGroups(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullArcs(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullAdjacency(phull);
+	if(r == 0)
+		return 0;
+	r = InitHullHalfEdges(phull);
+	if(r == 0)
+		return 0;
+
+	return InitHullSoa(phull);
+}
+
+//makes room for 'needed' elements in *array, doubling it
+static int QhGrow(struct qh_struct * qh, void ** array, int * max, int needed, int size)
+{
+	void * new_array;
+	int new_max;
+
+	if(needed <= *max)
+		return 1;
+	new_max = (*max > 0) ? *max : 16;
+	while(new_max < needed)
+	{
+		new_max *= 2;
+	}
+	new_array = realloc(*array, new_max*size);
+	if(new_array == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	qh->mem_bytes += (new_max - *max)*size;
+	if(qh->mem_bytes > qh->peak_bytes)
+		qh->peak_bytes = qh->mem_bytes;
+	*array = new_array;
+	*max = new_max;
+
+	return 1;
+}
+
+//scratch memory that lives until QhFree(), counted in the peak
+static void * QhAlloc(struct qh_struct * qh, int size)
+{
+	void * mem;
+
+	if(qh->num_blocks == QH_MAX_BLOCKS)
+		return 0;
+	mem = malloc(size);
+	if(mem == 0)
+		return 0;
+	qh->blocks[qh->num_blocks] = mem;
+	qh->num_blocks += 1;
+	qh->mem_bytes += size;
+	if(qh->mem_bytes > qh->peak_bytes)
+		qh->peak_bytes = qh->mem_bytes;
+
+	return mem;
+}
+
+static void QhFree(struct qh_struct * qh)
+{
+	int i;
+
+	for(i = 0; i < qh->num_blocks; i++)
+	{
+		free(qh->blocks[i]);
+	}
+	free(qh->faces);
+	free(qh->stack);
+	free(qh->visible);
+	free(qh->horizon);
+	qh->num_blocks = 0;
+	qh->faces = 0;
+	qh->stack = 0;
+	qh->visible = 0;
+	qh->horizon = 0;
+}
+
+static int CompareX(const void * a, const void * b)
+{
+	float xa = *((const float*)a);
+	float xb = *((const float*)b);
+
+	if(xa < xb)
+		return -1;
+	if(xa > xb)
+		return 1;
+	return 0;
+}
+
+//sorts half edges by their unordered pair of vertices, so the two halves of an edge end up next to each other
+static int CompareHalfEdge(const void * a, const void * b)
+{
+	const struct qh_half_edge_struct * ha = (const struct qh_half_edge_struct*)a;
+	const struct qh_half_edge_struct * hb = (const struct qh_half_edge_struct*)b;
+	int lo_a = (ha->v[0] < ha->v[1]) ? ha->v[0] : ha->v[1];
+	int lo_b = (hb->v[0] < hb->v[1]) ? hb->v[0] : hb->v[1];
+	int hi_a = (ha->v[0] < ha->v[1]) ? ha->v[1] : ha->v[0];
+	int hi_b = (hb->v[0] < hb->v[1]) ? hb->v[1] : hb->v[0];
+
+	if(lo_a != lo_b)
+		return (lo_a < lo_b) ? -1 : 1;
+	if(hi_a != hi_b)
+		return (hi_a < hi_b) ? -1 : 1;
+	return 0;
+}
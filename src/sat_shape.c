@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sat.h"
+
+/*
+Shapes are hulls in body space that every body of that kind of shape shares. They
+never change after they are registered. A body keeps the handle of its shape and its
+transform, its hull pointer is either the shape itself (queries go through the
+body's transform) or a world space copy from a hull_pool_struct that UpdateHull()
+keeps current.
+*/
+
+int ShapeRegistryInit(struct shape_registry_struct * registry)
+{
+	memset(registry, 0, sizeof(struct shape_registry_struct));
+	registry->max_shapes = 4;
+	registry->hulls = (struct box_collision_struct**)malloc(registry->max_shapes*sizeof(struct box_collision_struct*));
+	if(registry->hulls == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+
+	return 1;
+}
+
+void ShapeRegistryFree(struct shape_registry_struct * registry)
+{
+	int i;
+
+	for(i = 0; i < registry->num_shapes; i++)
+	{
+		FreeHull(registry->hulls[i]);
+		free(registry->hulls[i]);
+	}
+	free(registry->hulls);
+	memset(registry, 0, sizeof(struct shape_registry_struct));
+}
+
+/*
+Takes over the arrays of 'hull', which must be made by InitHull() or InitPlaneHull() in
+the frame of the bodies that will use it. 'hull' is zero'd.
+returns the handle of the shape, -1 on failure.
+*/
+int ShapeRegister(struct shape_registry_struct * registry, struct box_collision_struct * hull)
+{
+	struct box_collision_struct ** new_hulls;
+	struct box_collision_struct * shape_hull;
+
+	if(registry->num_shapes == registry->max_shapes)
+	{
+		new_hulls = (struct box_collision_struct**)realloc(registry->hulls, registry->max_shapes*2*sizeof(struct box_collision_struct*));
+		if(new_hulls == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return -1;
+		}
+		registry->hulls = new_hulls;
+		registry->max_shapes *= 2;
+	}
+
+	shape_hull = (struct box_collision_struct*)malloc(sizeof(struct box_collision_struct));
+	if(shape_hull == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return -1;
+	}
+	memcpy(shape_hull, hull, sizeof(struct box_collision_struct));
+	shape_hull->is_local = 1;
+	memset(hull, 0, sizeof(struct box_collision_struct));
+
+	registry->hulls[registry->num_shapes] = shape_hull;
+	registry->num_shapes += 1;
+
+	return (registry->num_shapes-1);
+}
+
+struct box_collision_struct * ShapeGetHull(struct shape_registry_struct * registry, int shape)
+{
+	if(shape < 0 || shape >= registry->num_shapes)
+		return 0;
+	return registry->hulls[shape];
+}
+
+//makes the body use its shape directly, in local space
+void SetBodyShape(struct shape_registry_struct * registry, struct box_struct * box, int shape)
+{
+	box->shape = shape;
+	box->hull = registry->hulls[shape];
+}
+
+/*
+Allocates num_hulls world space copies of a shape. The topology (axis groups, face
+vertex indices, adjacency and half edges) is read only and shared with the shape,
+everything UpdateHull() writes is copied.
+*/
+int HullPoolInit(struct hull_pool_struct * pool, struct box_collision_struct * shape_hull, int num_hulls)
+{
+	struct box_collision_struct * hull;
+	void * mem=0;
+	int i;
+	int r;
+
+	memset(pool, 0, sizeof(struct hull_pool_struct));
+	if(num_hulls <= 0)
+		return 1;
+
+	pool->hulls = (struct box_collision_struct*)malloc(num_hulls*sizeof(struct box_collision_struct));
+	pool->positions = (float*)malloc(num_hulls*shape_hull->num_pos*3*sizeof(float));
+	pool->faces = (struct face_struct*)malloc(num_hulls*shape_hull->num_faces*sizeof(struct face_struct));
+	pool->edges = (struct edge_struct*)malloc(num_hulls*shape_hull->num_edges*sizeof(struct edge_struct));
+	if(shape_hull->arcs != 0)
+		pool->arcs = (struct gauss_arc_struct*)malloc(num_hulls*shape_hull->num_edges*sizeof(struct gauss_arc_struct));
+	if(shape_hull->soa != 0)
+	{
+		//num_soa is a multiple of SAT_SIMD_WIDTH so every hull's soa stays aligned
+		r = posix_memalign(&mem, (SAT_SIMD_WIDTH*sizeof(float)), (num_hulls*3*shape_hull->num_soa*sizeof(float)));
+		if(r == 0)
+			pool->soa = (float*)mem;
+	}
+	if(pool->hulls == 0 || pool->positions == 0 || pool->faces == 0 || pool->edges == 0
+		|| (shape_hull->arcs != 0 && pool->arcs == 0) || (shape_hull->soa != 0 && pool->soa == 0))
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		HullPoolFree(pool);
+		return 0;
+	}
+	pool->num_hulls = num_hulls;
+
+	for(i = 0; i < num_hulls; i++)
+	{
+		hull = pool->hulls+i;
+		memcpy(hull, shape_hull, sizeof(struct box_collision_struct));
+		hull->is_local = 0;
+		hull->positions = pool->positions+(i*shape_hull->num_pos*3);
+		hull->faces = pool->faces+(i*shape_hull->num_faces);
+		hull->edges = pool->edges+(i*shape_hull->num_edges);
+		memcpy(hull->positions, shape_hull->positions, shape_hull->num_pos*3*sizeof(float));
+		memcpy(hull->faces, shape_hull->faces, shape_hull->num_faces*sizeof(struct face_struct));
+		memcpy(hull->edges, shape_hull->edges, shape_hull->num_edges*sizeof(struct edge_struct));
+		if(shape_hull->arcs != 0)
+		{
+			hull->arcs = pool->arcs+(i*shape_hull->num_edges);
+			memcpy(hull->arcs, shape_hull->arcs, shape_hull->num_edges*sizeof(struct gauss_arc_struct));
+		}
+		if(shape_hull->soa != 0)
+		{
+			hull->soa = pool->soa+(i*3*shape_hull->num_soa);
+			UpdateHullSoa(hull);
+		}
+	}
+
+	return 1;
+}
+
+void HullPoolFree(struct hull_pool_struct * pool)
+{
+	free(pool->hulls);
+	free(pool->positions);
+	free(pool->faces);
+	free(pool->edges);
+	free(pool->arcs);
+	free(pool->soa);
+	memset(pool, 0, sizeof(struct hull_pool_struct));
+}
+
+//gives the body world space copy i_hull of the pool. The body's shape must be the pool's shape.
+void SetBodyWorldHull(struct hull_pool_struct * pool, struct box_struct * box, int i_hull)
+{
+	box->hull = pool->hulls+i_hull;
+}
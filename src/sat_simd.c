@@ -0,0 +1,762 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <math.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SAT_HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "sat.h"
+
+/*
+Support point and projection kernels over the structure-of-arrays copy of a hull's positions.
+Each kernel returns the index of the vertex with the smallest dot product with 'dir'
+and writes that dot product to 'min_dot'. On ties the lowest index wins, so every
+kernel picks the same vertex as the scalar loop in HullFindSupport().
+The sum is always (x*dx + y*dy) + z*dz without fma, so the dot products are bit
+identical to vDotProduct().
+The SSE and AVX2 kernels are compiled with target attributes and picked at runtime
+from what the cpu supports, so the library itself doesn't need -mavx2.
+
+SolveContactLanes() runs the contact solver of sat_solver.c on a lane group: up to
+SAT_SOLVER_LANES manifolds of one color, which share no body, with contact slot j of
+every manifold in block j. The velocities of the lanes' bodies are gathered once,
+the blocks are solved in order 'num_passes' times and the velocities are scattered
+back, so each manifold sees its contacts in the same order as SolveContact(). The
+arithmetic is the same too, which keeps the impulses bit identical to the row solver.
+*/
+
+//rows of the velocity buffer of a lane group
+#define LANE_VEL0 0		//linear velocity of body 0
+#define LANE_W0 3		//angular velocity of body 0
+#define LANE_VEL1 6
+#define LANE_W1 9
+#define LANE_VELS 12
+
+static int FindSupportScalar(float * soa, int num_soa, float * dir, float * min_dot);
+static int FindSupportDispatch(float * soa, int num_soa, float * dir, float * min_dot);
+static void ProjectScalar(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot);
+static void ProjectDispatch(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot);
+static void SolveLanesScalar(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual);
+static void SolveLanesDispatch(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual);
+static void GatherLaneBodies(int * lane_bodies, struct solver_body_struct * bodies, float * vel);
+static void ScatterLaneBodies(int * lane_bodies, struct solver_body_struct * bodies, float * vel);
+static int GetCpuSimdLevel(void);
+#ifdef SAT_HAVE_X86_SIMD
+static int FindSupportSse(float * soa, int num_soa, float * dir, float * min_dot);
+static int FindSupportAvx2(float * soa, int num_soa, float * dir, float * min_dot);
+static void ProjectSse(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot);
+static void ProjectAvx2(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot);
+static void SolveLanesSse(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual);
+static void SolveLanesAvx2(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual);
+#endif
+
+static int (*g_find_support)(float * soa, int num_soa, float * dir, float * min_dot) = FindSupportDispatch;
+static void (*g_project)(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot) = ProjectDispatch;
+static void (*g_solve_lanes)(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual) = SolveLanesDispatch;
+static int g_simd_level = -1;	//-1 until the cpu has been checked
+static const struct solver_body_struct g_zero_body;	//what the ground and empty lanes of a lane group read
+
+int SatGetSimdLevel(void)
+{
+	if(g_simd_level < 0)
+		SatSetSimdLevel(SAT_SIMD_AVX2);
+	return g_simd_level;
+}
+
+/*
+Selects the kernel used by FindSupportSoa(). 'level' is lowered to what the cpu
+supports. returns the level actually used.
+*/
+int SatSetSimdLevel(int level)
+{
+	int cpu_level;
+
+	cpu_level = GetCpuSimdLevel();
+	if(level > cpu_level)
+		level = cpu_level;
+	if(level < SAT_SIMD_SCALAR)
+		level = SAT_SIMD_SCALAR;
+
+	g_find_support = FindSupportScalar;
+	g_project = ProjectScalar;
+	g_solve_lanes = SolveLanesScalar;
+#ifdef SAT_HAVE_X86_SIMD
+	if(level == SAT_SIMD_SSE)
+	{
+		g_find_support = FindSupportSse;
+		g_project = ProjectSse;
+		g_solve_lanes = SolveLanesSse;
+	}
+	else if(level == SAT_SIMD_AVX2)
+	{
+		g_find_support = FindSupportAvx2;
+		g_project = ProjectAvx2;
+		g_solve_lanes = SolveLanesAvx2;
+	}
+#endif
+	g_simd_level = level;
+
+	return level;
+}
+
+//'soa' holds x[num_soa], y[num_soa], z[num_soa]. num_soa must be a multiple of SAT_SIMD_WIDTH
+int FindSupportSoa(float * soa, int num_soa, float * dir, float * min_dot)
+{
+	return g_find_support(soa, num_soa, dir, min_dot);
+}
+
+//min and max dot product of the vertices with 'dir', the interval of the hull along 'dir'
+void ProjectSoa(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot)
+{
+	g_project(soa, num_soa, dir, min_dot, max_dot);
+}
+
+/*
+Solves the 'num_blocks' blocks of a lane group 'num_passes' times. 'lane_bodies'
+holds body 0 of each lane followed by body 1, -1 for the ground or an empty lane.
+The largest impulse change is written to 'residual' if it is bigger than what it holds.
+*/
+void SolveContactLanes(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual)
+{
+	g_solve_lanes(lane_rows, num_blocks, num_passes, lane_bodies, bodies, residual);
+}
+
+static int FindSupportDispatch(float * soa, int num_soa, float * dir, float * min_dot)
+{
+	SatGetSimdLevel();
+	return g_find_support(soa, num_soa, dir, min_dot);
+}
+
+static void ProjectDispatch(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot)
+{
+	SatGetSimdLevel();
+	g_project(soa, num_soa, dir, min_dot, max_dot);
+}
+
+static void SolveLanesDispatch(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual)
+{
+	SatGetSimdLevel();
+	g_solve_lanes(lane_rows, num_blocks, num_passes, lane_bodies, bodies, residual);
+}
+
+//copies the velocities of the lanes' bodies into 'vel', LANE_VELS rows of SAT_SOLVER_LANES. the ground and empty lanes read zeros.
+static void GatherLaneBodies(int * lane_bodies, struct solver_body_struct * bodies, float * vel)
+{
+	const struct solver_body_struct * sbody;
+	int i_body;
+	int j;
+	int k;
+	int l;
+
+	for(j = 0; j < 2; j++)
+	{
+		for(l = 0; l < SAT_SOLVER_LANES; l++)
+		{
+			i_body = lane_bodies[(j*SAT_SOLVER_LANES)+l];
+			sbody = (i_body == -1) ? &g_zero_body : (bodies+i_body);
+			for(k = 0; k < 3; k++)
+			{
+				vel[(((j*LANE_VEL1)+LANE_VEL0+k)*SAT_SOLVER_LANES)+l] = sbody->linear_vel[k];
+				vel[(((j*LANE_VEL1)+LANE_W0+k)*SAT_SOLVER_LANES)+l] = sbody->angular_vel[k];
+			}
+		}
+	}
+}
+
+static void ScatterLaneBodies(int * lane_bodies, struct solver_body_struct * bodies, float * vel)
+{
+	struct solver_body_struct * sbody;
+	int i_body;
+	int j;
+	int k;
+	int l;
+
+	for(j = 0; j < 2; j++)
+	{
+		for(l = 0; l < SAT_SOLVER_LANES; l++)
+		{
+			i_body = lane_bodies[(j*SAT_SOLVER_LANES)+l];
+			if(i_body == -1)
+				continue;
+			sbody = bodies+i_body;
+			for(k = 0; k < 3; k++)
+			{
+				sbody->linear_vel[k] = vel[(((j*LANE_VEL1)+LANE_VEL0+k)*SAT_SOLVER_LANES)+l];
+				sbody->angular_vel[k] = vel[(((j*LANE_VEL1)+LANE_W0+k)*SAT_SOLVER_LANES)+l];
+			}
+		}
+	}
+}
+
+static int GetCpuSimdLevel(void)
+{
+#ifdef SAT_HAVE_X86_SIMD
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return SAT_SIMD_AVX2;
+	if(__builtin_cpu_supports("sse4.1"))
+		return SAT_SIMD_SSE;
+#endif
+	return SAT_SIMD_SCALAR;
+}
+
+static int FindSupportScalar(float * soa, int num_soa, float * dir, float * min_dot)
+{
+	float * x;
+	float * y;
+	float * z;
+	float dot;
+	float best;
+	int best_i;
+	int i;
+
+	x = soa;
+	y = soa + num_soa;
+	z = soa + (2*num_soa);
+	best = ((x[0]*dir[0]) + (y[0]*dir[1])) + (z[0]*dir[2]);
+	best_i = 0;
+	for(i = 1; i < num_soa; i++)
+	{
+		dot = ((x[i]*dir[0]) + (y[i]*dir[1])) + (z[i]*dir[2]);
+		if(dot < best)
+		{
+			best = dot;
+			best_i = i;
+		}
+	}
+	*min_dot = best;
+
+	return best_i;
+}
+
+static void ProjectScalar(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot)
+{
+	float * x;
+	float * y;
+	float * z;
+	float dot;
+	float min_d;
+	float max_d;
+	int i;
+
+	x = soa;
+	y = soa + num_soa;
+	z = soa + (2*num_soa);
+	min_d = ((x[0]*dir[0]) + (y[0]*dir[1])) + (z[0]*dir[2]);
+	max_d = min_d;
+	for(i = 1; i < num_soa; i++)
+	{
+		dot = ((x[i]*dir[0]) + (y[i]*dir[1])) + (z[i]*dir[2]);
+		if(dot < min_d)
+			min_d = dot;
+		if(dot > max_d)
+			max_d = dot;
+	}
+	*min_dot = min_d;
+	*max_dot = max_d;
+}
+
+//same steps as SolveContact() and ApplySolverImpulse(), one lane at a time
+static void SolveLanesScalar(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual)
+{
+	float vel[LANE_VELS*SAT_SOLVER_LANES];
+	float delta_vel[3];
+	float cross_vec[2][3];
+	float * rows;
+	float * v;
+	float old_impulse;
+	float impulse;
+	float d;
+	int p;
+	int b;
+	int j;
+	int k;
+	int l;
+
+	GatherLaneBodies(lane_bodies, bodies, vel);
+	for(p = 0; p < num_passes; p++)
+	{
+		for(b = 0; b < num_blocks; b++)
+		{
+			rows = lane_rows + (b*SAT_LANE_FIELDS*SAT_SOLVER_LANES);
+			for(l = 0; l < SAT_SOLVER_LANES; l++)
+			{
+				v = vel + l;
+				//dV = v_0 + (w_0 cross r_0) - v_1 - (w_1 cross r_1)
+				for(j = 0; j < 2; j++)
+				{
+					for(k = 0; k < 3; k++)
+					{
+						cross_vec[j][k] = (v[((j*LANE_VEL1)+LANE_W0+((k+1)%3))*SAT_SOLVER_LANES]*rows[((j*3)+SAT_LANE_R0+((k+2)%3))*SAT_SOLVER_LANES+l])
+							- (v[((j*LANE_VEL1)+LANE_W0+((k+2)%3))*SAT_SOLVER_LANES]*rows[((j*3)+SAT_LANE_R0+((k+1)%3))*SAT_SOLVER_LANES+l]);
+					}
+				}
+				for(k = 0; k < 3; k++)
+				{
+					delta_vel[k] = (v[(LANE_VEL0+k)*SAT_SOLVER_LANES] + cross_vec[0][k]) - (v[(LANE_VEL1+k)*SAT_SOLVER_LANES] + cross_vec[1][k]);
+				}
+
+				old_impulse = rows[(SAT_LANE_IMPULSE*SAT_SOLVER_LANES)+l];
+				impulse = old_impulse + (((-1.0f*(((delta_vel[0]*rows[(SAT_LANE_NORMAL*SAT_SOLVER_LANES)+l]) + (delta_vel[1]*rows[((SAT_LANE_NORMAL+1)*SAT_SOLVER_LANES)+l])) + (delta_vel[2]*rows[((SAT_LANE_NORMAL+2)*SAT_SOLVER_LANES)+l])))
+					+ rows[(SAT_LANE_BIAS*SAT_SOLVER_LANES)+l])*rows[(SAT_LANE_INV_K*SAT_SOLVER_LANES)+l]);
+				if(impulse < 0.0f)
+					impulse = 0.0f;
+				rows[(SAT_LANE_IMPULSE*SAT_SOLVER_LANES)+l] = impulse;
+				if(fabsf(impulse - old_impulse) > *residual)
+					*residual = fabsf(impulse - old_impulse);
+
+				//applies the change along the normal to body 0 and the opposite one to body 1
+				d = impulse - old_impulse;
+				for(j = 0; j < 2; j++)
+				{
+					for(k = 0; k < 3; k++)
+					{
+						v[((j*LANE_VEL1)+LANE_VEL0+k)*SAT_SOLVER_LANES] += d*rows[(SAT_LANE_INV_MASS0+j)*SAT_SOLVER_LANES+l]*rows[(SAT_LANE_NORMAL+k)*SAT_SOLVER_LANES+l];
+						v[((j*LANE_VEL1)+LANE_W0+k)*SAT_SOLVER_LANES] += d*rows[((j*3)+SAT_LANE_INV_I_RXN0+k)*SAT_SOLVER_LANES+l];
+					}
+					d = -1.0f*(impulse - old_impulse);
+				}
+			}
+		}
+	}
+	ScatterLaneBodies(lane_bodies, bodies, vel);
+}
+
+#ifdef SAT_HAVE_X86_SIMD
+__attribute__((target("sse4.1")))
+static int FindSupportSse(float * soa, int num_soa, float * dir, float * min_dot)
+{
+	__m128 dx = _mm_set1_ps(dir[0]);
+	__m128 dy = _mm_set1_ps(dir[1]);
+	__m128 dz = _mm_set1_ps(dir[2]);
+	__m128i idx = _mm_setr_epi32(0, 1, 2, 3);
+	__m128i step = _mm_set1_epi32(4);
+	__m128 best;
+	__m128i best_i;
+	__m128 dot;
+	__m128 mask;
+	__m128 m;
+	__m128i cand;
+	float * x;
+	float * y;
+	float * z;
+	int i;
+
+	x = soa;
+	y = soa + num_soa;
+	z = soa + (2*num_soa);
+
+	//each lane keeps the first minimum of the vertices it sees
+	best = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(x), dx), _mm_mul_ps(_mm_load_ps(y), dy)), _mm_mul_ps(_mm_load_ps(z), dz));
+	best_i = idx;
+	for(i = 4; i < num_soa; i += 4)
+	{
+		idx = _mm_add_epi32(idx, step);
+		dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(x+i), dx), _mm_mul_ps(_mm_load_ps(y+i), dy)), _mm_mul_ps(_mm_load_ps(z+i), dz));
+		mask = _mm_cmplt_ps(dot, best);
+		best = _mm_blendv_ps(best, dot, mask);
+		best_i = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(best_i), _mm_castsi128_ps(idx), mask));
+	}
+
+	//horizontal min, then the lowest index among the lanes holding it
+	m = _mm_min_ps(best, _mm_shuffle_ps(best, best, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm_min_ps(m, _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	mask = _mm_cmpeq_ps(best, m);
+	cand = _mm_castps_si128(_mm_blendv_ps(_mm_castsi128_ps(_mm_set1_epi32(INT_MAX)), _mm_castsi128_ps(best_i), mask));
+	cand = _mm_min_epi32(cand, _mm_shuffle_epi32(cand, _MM_SHUFFLE(1, 0, 3, 2)));
+	cand = _mm_min_epi32(cand, _mm_shuffle_epi32(cand, _MM_SHUFFLE(2, 3, 0, 1)));
+	i = _mm_cvtsi128_si32(cand);
+	if(i == INT_MAX)
+		return FindSupportScalar(soa, num_soa, dir, min_dot); //nan direction, no lane compares equal
+	*min_dot = ((x[i]*dir[0]) + (y[i]*dir[1])) + (z[i]*dir[2]); //recomputed so -0.0 vs 0.0 matches the scalar kernel
+
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int FindSupportAvx2(float * soa, int num_soa, float * dir, float * min_dot)
+{
+	__m256 dx = _mm256_set1_ps(dir[0]);
+	__m256 dy = _mm256_set1_ps(dir[1]);
+	__m256 dz = _mm256_set1_ps(dir[2]);
+	__m256i idx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256i step = _mm256_set1_epi32(8);
+	__m256 best;
+	__m256i best_i;
+	__m256 dot;
+	__m256 mask;
+	__m256 m;
+	__m256i cand;
+	float * x;
+	float * y;
+	float * z;
+	int i;
+
+	x = soa;
+	y = soa + num_soa;
+	z = soa + (2*num_soa);
+
+	best = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(x), dx), _mm256_mul_ps(_mm256_load_ps(y), dy)), _mm256_mul_ps(_mm256_load_ps(z), dz));
+	best_i = idx;
+	for(i = 8; i < num_soa; i += 8)
+	{
+		idx = _mm256_add_epi32(idx, step);
+		dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(x+i), dx), _mm256_mul_ps(_mm256_load_ps(y+i), dy)), _mm256_mul_ps(_mm256_load_ps(z+i), dz));
+		mask = _mm256_cmp_ps(dot, best, _CMP_LT_OQ);
+		best = _mm256_blendv_ps(best, dot, mask);
+		best_i = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(best_i), _mm256_castsi256_ps(idx), mask));
+	}
+
+	m = _mm256_min_ps(best, _mm256_permute2f128_ps(best, best, 1));
+	m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(1, 0, 3, 2)));
+	m = _mm256_min_ps(m, _mm256_shuffle_ps(m, m, _MM_SHUFFLE(2, 3, 0, 1)));
+	mask = _mm256_cmp_ps(best, m, _CMP_EQ_OQ);
+	cand = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(_mm256_set1_epi32(INT_MAX)), _mm256_castsi256_ps(best_i), mask));
+	cand = _mm256_min_epi32(cand, _mm256_permute2x128_si256(cand, cand, 1));
+	cand = _mm256_min_epi32(cand, _mm256_shuffle_epi32(cand, _MM_SHUFFLE(1, 0, 3, 2)));
+	cand = _mm256_min_epi32(cand, _mm256_shuffle_epi32(cand, _MM_SHUFFLE(2, 3, 0, 1)));
+	i = _mm256_cvtsi256_si32(cand);
+	if(i == INT_MAX)
+		return FindSupportScalar(soa, num_soa, dir, min_dot); //nan direction, no lane compares equal
+	*min_dot = ((x[i]*dir[0]) + (y[i]*dir[1])) + (z[i]*dir[2]); //recomputed so -0.0 vs 0.0 matches the scalar kernel
+
+	return i;
+}
+__attribute__((target("sse4.1")))
+static void ProjectSse(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot)
+{
+	__m128 dx = _mm_set1_ps(dir[0]);
+	__m128 dy = _mm_set1_ps(dir[1]);
+	__m128 dz = _mm_set1_ps(dir[2]);
+	__m128 min_d;
+	__m128 max_d;
+	__m128 dot;
+	float * x;
+	float * y;
+	float * z;
+	int i;
+
+	x = soa;
+	y = soa + num_soa;
+	z = soa + (2*num_soa);
+
+	min_d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(x), dx), _mm_mul_ps(_mm_load_ps(y), dy)), _mm_mul_ps(_mm_load_ps(z), dz));
+	max_d = min_d;
+	for(i = 4; i < num_soa; i += 4)
+	{
+		dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_load_ps(x+i), dx), _mm_mul_ps(_mm_load_ps(y+i), dy)), _mm_mul_ps(_mm_load_ps(z+i), dz));
+		min_d = _mm_min_ps(min_d, dot);
+		max_d = _mm_max_ps(max_d, dot);
+	}
+	min_d = _mm_min_ps(min_d, _mm_shuffle_ps(min_d, min_d, _MM_SHUFFLE(1, 0, 3, 2)));
+	min_d = _mm_min_ps(min_d, _mm_shuffle_ps(min_d, min_d, _MM_SHUFFLE(2, 3, 0, 1)));
+	max_d = _mm_max_ps(max_d, _mm_shuffle_ps(max_d, max_d, _MM_SHUFFLE(1, 0, 3, 2)));
+	max_d = _mm_max_ps(max_d, _mm_shuffle_ps(max_d, max_d, _MM_SHUFFLE(2, 3, 0, 1)));
+	*min_dot = _mm_cvtss_f32(min_d);
+	*max_dot = _mm_cvtss_f32(max_d);
+}
+
+__attribute__((target("avx2")))
+static void ProjectAvx2(float * soa, int num_soa, float * dir, float * min_dot, float * max_dot)
+{
+	__m256 dx = _mm256_set1_ps(dir[0]);
+	__m256 dy = _mm256_set1_ps(dir[1]);
+	__m256 dz = _mm256_set1_ps(dir[2]);
+	__m256 min_d;
+	__m256 max_d;
+	__m256 dot;
+	float * x;
+	float * y;
+	float * z;
+	int i;
+
+	x = soa;
+	y = soa + num_soa;
+	z = soa + (2*num_soa);
+
+	min_d = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(x), dx), _mm256_mul_ps(_mm256_load_ps(y), dy)), _mm256_mul_ps(_mm256_load_ps(z), dz));
+	max_d = min_d;
+	for(i = 8; i < num_soa; i += 8)
+	{
+		dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(x+i), dx), _mm256_mul_ps(_mm256_load_ps(y+i), dy)), _mm256_mul_ps(_mm256_load_ps(z+i), dz));
+		min_d = _mm256_min_ps(min_d, dot);
+		max_d = _mm256_max_ps(max_d, dot);
+	}
+	min_d = _mm256_min_ps(min_d, _mm256_permute2f128_ps(min_d, min_d, 1));
+	min_d = _mm256_min_ps(min_d, _mm256_shuffle_ps(min_d, min_d, _MM_SHUFFLE(1, 0, 3, 2)));
+	min_d = _mm256_min_ps(min_d, _mm256_shuffle_ps(min_d, min_d, _MM_SHUFFLE(2, 3, 0, 1)));
+	max_d = _mm256_max_ps(max_d, _mm256_permute2f128_ps(max_d, max_d, 1));
+	max_d = _mm256_max_ps(max_d, _mm256_shuffle_ps(max_d, max_d, _MM_SHUFFLE(1, 0, 3, 2)));
+	max_d = _mm256_max_ps(max_d, _mm256_shuffle_ps(max_d, max_d, _MM_SHUFFLE(2, 3, 0, 1)));
+	*min_dot = _mm256_cvtss_f32(min_d);
+	*max_dot = _mm256_cvtss_f32(max_d);
+}
+
+__attribute__((target("sse4.1")))
+static void SolveLanesSse(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual)
+{
+	float vel[LANE_VELS*SAT_SOLVER_LANES] __attribute__((aligned(32)));
+	float res_lanes[4] __attribute__((aligned(16)));
+	__m128 zero = _mm_setzero_ps();
+	__m128 sign_bit = _mm_set1_ps(-0.0f);
+	__m128 v0x;
+	__m128 v0y;
+	__m128 v0z;
+	__m128 w0x;
+	__m128 w0y;
+	__m128 w0z;
+	__m128 v1x;
+	__m128 v1y;
+	__m128 v1z;
+	__m128 w1x;
+	__m128 w1y;
+	__m128 w1z;
+	__m128 nx;
+	__m128 ny;
+	__m128 nz;
+	__m128 rx;
+	__m128 ry;
+	__m128 rz;
+	__m128 dvx;
+	__m128 dvy;
+	__m128 dvz;
+	__m128 dot;
+	__m128 old_impulse;
+	__m128 impulse;
+	__m128 d;
+	__m128 m;
+	__m128 res;
+	float * rows;
+	float * v;
+	int h;
+	int p;
+	int b;
+	int k;
+
+	GatherLaneBodies(lane_bodies, bodies, vel);
+	res = zero;
+
+	//the two halves of the group have no body in common
+	for(h = 0; h < SAT_SOLVER_LANES; h += 4)
+	{
+		v = vel+h;
+		v0x = _mm_load_ps(v+((LANE_VEL0+0)*SAT_SOLVER_LANES));
+		v0y = _mm_load_ps(v+((LANE_VEL0+1)*SAT_SOLVER_LANES));
+		v0z = _mm_load_ps(v+((LANE_VEL0+2)*SAT_SOLVER_LANES));
+		w0x = _mm_load_ps(v+((LANE_W0+0)*SAT_SOLVER_LANES));
+		w0y = _mm_load_ps(v+((LANE_W0+1)*SAT_SOLVER_LANES));
+		w0z = _mm_load_ps(v+((LANE_W0+2)*SAT_SOLVER_LANES));
+		v1x = _mm_load_ps(v+((LANE_VEL1+0)*SAT_SOLVER_LANES));
+		v1y = _mm_load_ps(v+((LANE_VEL1+1)*SAT_SOLVER_LANES));
+		v1z = _mm_load_ps(v+((LANE_VEL1+2)*SAT_SOLVER_LANES));
+		w1x = _mm_load_ps(v+((LANE_W1+0)*SAT_SOLVER_LANES));
+		w1y = _mm_load_ps(v+((LANE_W1+1)*SAT_SOLVER_LANES));
+		w1z = _mm_load_ps(v+((LANE_W1+2)*SAT_SOLVER_LANES));
+
+		for(p = 0; p < num_passes; p++)
+		{
+			for(b = 0; b < num_blocks; b++)
+			{
+				rows = lane_rows + (b*SAT_LANE_FIELDS*SAT_SOLVER_LANES)+h;
+				nx = _mm_load_ps(rows+((SAT_LANE_NORMAL+0)*SAT_SOLVER_LANES));
+				ny = _mm_load_ps(rows+((SAT_LANE_NORMAL+1)*SAT_SOLVER_LANES));
+				nz = _mm_load_ps(rows+((SAT_LANE_NORMAL+2)*SAT_SOLVER_LANES));
+
+				//dV = v_0 + (w_0 cross r_0) - v_1 - (w_1 cross r_1)
+				rx = _mm_load_ps(rows+((SAT_LANE_R0+0)*SAT_SOLVER_LANES));
+				ry = _mm_load_ps(rows+((SAT_LANE_R0+1)*SAT_SOLVER_LANES));
+				rz = _mm_load_ps(rows+((SAT_LANE_R0+2)*SAT_SOLVER_LANES));
+				dvx = _mm_add_ps(v0x, _mm_sub_ps(_mm_mul_ps(w0y, rz), _mm_mul_ps(w0z, ry)));
+				dvy = _mm_add_ps(v0y, _mm_sub_ps(_mm_mul_ps(w0z, rx), _mm_mul_ps(w0x, rz)));
+				dvz = _mm_add_ps(v0z, _mm_sub_ps(_mm_mul_ps(w0x, ry), _mm_mul_ps(w0y, rx)));
+				rx = _mm_load_ps(rows+((SAT_LANE_R1+0)*SAT_SOLVER_LANES));
+				ry = _mm_load_ps(rows+((SAT_LANE_R1+1)*SAT_SOLVER_LANES));
+				rz = _mm_load_ps(rows+((SAT_LANE_R1+2)*SAT_SOLVER_LANES));
+				dvx = _mm_sub_ps(dvx, _mm_add_ps(v1x, _mm_sub_ps(_mm_mul_ps(w1y, rz), _mm_mul_ps(w1z, ry))));
+				dvy = _mm_sub_ps(dvy, _mm_add_ps(v1y, _mm_sub_ps(_mm_mul_ps(w1z, rx), _mm_mul_ps(w1x, rz))));
+				dvz = _mm_sub_ps(dvz, _mm_add_ps(v1z, _mm_sub_ps(_mm_mul_ps(w1x, ry), _mm_mul_ps(w1y, rx))));
+
+				//the accumulated impulse is clamped at 0. the max keeps 'res' when the change is nan, like the scalar compare
+				dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dvx, nx), _mm_mul_ps(dvy, ny)), _mm_mul_ps(dvz, nz));
+				old_impulse = _mm_load_ps(rows+(SAT_LANE_IMPULSE*SAT_SOLVER_LANES));
+				impulse = _mm_add_ps(old_impulse, _mm_mul_ps(_mm_add_ps(_mm_xor_ps(dot, sign_bit), _mm_load_ps(rows+(SAT_LANE_BIAS*SAT_SOLVER_LANES))), _mm_load_ps(rows+(SAT_LANE_INV_K*SAT_SOLVER_LANES))));
+				impulse = _mm_blendv_ps(impulse, zero, _mm_cmplt_ps(impulse, zero));
+				_mm_store_ps(rows+(SAT_LANE_IMPULSE*SAT_SOLVER_LANES), impulse);
+				d = _mm_sub_ps(impulse, old_impulse);
+				res = _mm_max_ps(_mm_andnot_ps(sign_bit, d), res);
+
+				//the change along the normal to body 0 and the opposite one to body 1
+				m = _mm_mul_ps(d, _mm_load_ps(rows+(SAT_LANE_INV_MASS0*SAT_SOLVER_LANES)));
+				v0x = _mm_add_ps(v0x, _mm_mul_ps(m, nx));
+				v0y = _mm_add_ps(v0y, _mm_mul_ps(m, ny));
+				v0z = _mm_add_ps(v0z, _mm_mul_ps(m, nz));
+				w0x = _mm_add_ps(w0x, _mm_mul_ps(d, _mm_load_ps(rows+((SAT_LANE_INV_I_RXN0+0)*SAT_SOLVER_LANES))));
+				w0y = _mm_add_ps(w0y, _mm_mul_ps(d, _mm_load_ps(rows+((SAT_LANE_INV_I_RXN0+1)*SAT_SOLVER_LANES))));
+				w0z = _mm_add_ps(w0z, _mm_mul_ps(d, _mm_load_ps(rows+((SAT_LANE_INV_I_RXN0+2)*SAT_SOLVER_LANES))));
+				d = _mm_xor_ps(d, sign_bit);
+				m = _mm_mul_ps(d, _mm_load_ps(rows+(SAT_LANE_INV_MASS1*SAT_SOLVER_LANES)));
+				v1x = _mm_add_ps(v1x, _mm_mul_ps(m, nx));
+				v1y = _mm_add_ps(v1y, _mm_mul_ps(m, ny));
+				v1z = _mm_add_ps(v1z, _mm_mul_ps(m, nz));
+				w1x = _mm_add_ps(w1x, _mm_mul_ps(d, _mm_load_ps(rows+((SAT_LANE_INV_I_RXN1+0)*SAT_SOLVER_LANES))));
+				w1y = _mm_add_ps(w1y, _mm_mul_ps(d, _mm_load_ps(rows+((SAT_LANE_INV_I_RXN1+1)*SAT_SOLVER_LANES))));
+				w1z = _mm_add_ps(w1z, _mm_mul_ps(d, _mm_load_ps(rows+((SAT_LANE_INV_I_RXN1+2)*SAT_SOLVER_LANES))));
+			}
+		}
+
+		_mm_store_ps(v+((LANE_VEL0+0)*SAT_SOLVER_LANES), v0x);
+		_mm_store_ps(v+((LANE_VEL0+1)*SAT_SOLVER_LANES), v0y);
+		_mm_store_ps(v+((LANE_VEL0+2)*SAT_SOLVER_LANES), v0z);
+		_mm_store_ps(v+((LANE_W0+0)*SAT_SOLVER_LANES), w0x);
+		_mm_store_ps(v+((LANE_W0+1)*SAT_SOLVER_LANES), w0y);
+		_mm_store_ps(v+((LANE_W0+2)*SAT_SOLVER_LANES), w0z);
+		_mm_store_ps(v+((LANE_VEL1+0)*SAT_SOLVER_LANES), v1x);
+		_mm_store_ps(v+((LANE_VEL1+1)*SAT_SOLVER_LANES), v1y);
+		_mm_store_ps(v+((LANE_VEL1+2)*SAT_SOLVER_LANES), v1z);
+		_mm_store_ps(v+((LANE_W1+0)*SAT_SOLVER_LANES), w1x);
+		_mm_store_ps(v+((LANE_W1+1)*SAT_SOLVER_LANES), w1y);
+		_mm_store_ps(v+((LANE_W1+2)*SAT_SOLVER_LANES), w1z);
+	}
+	ScatterLaneBodies(lane_bodies, bodies, vel);
+
+	_mm_store_ps(res_lanes, res);
+	for(k = 0; k < 4; k++)
+	{
+		if(res_lanes[k] > *residual)
+			*residual = res_lanes[k];
+	}
+}
+
+__attribute__((target("avx2")))
+static void SolveLanesAvx2(float * lane_rows, int num_blocks, int num_passes, int * lane_bodies, struct solver_body_struct * bodies, float * residual)
+{
+	float vel[LANE_VELS*SAT_SOLVER_LANES] __attribute__((aligned(32)));
+	float res_lanes[8] __attribute__((aligned(32)));
+	__m256 zero = _mm256_setzero_ps();
+	__m256 sign_bit = _mm256_set1_ps(-0.0f);
+	__m256 v0x;
+	__m256 v0y;
+	__m256 v0z;
+	__m256 w0x;
+	__m256 w0y;
+	__m256 w0z;
+	__m256 v1x;
+	__m256 v1y;
+	__m256 v1z;
+	__m256 w1x;
+	__m256 w1y;
+	__m256 w1z;
+	__m256 nx;
+	__m256 ny;
+	__m256 nz;
+	__m256 rx;
+	__m256 ry;
+	__m256 rz;
+	__m256 dvx;
+	__m256 dvy;
+	__m256 dvz;
+	__m256 dot;
+	__m256 old_impulse;
+	__m256 impulse;
+	__m256 d;
+	__m256 m;
+	__m256 res;
+	float * rows;
+	float * v;
+	int p;
+	int b;
+	int k;
+
+	GatherLaneBodies(lane_bodies, bodies, vel);
+	res = zero;
+	v = vel;
+	v0x = _mm256_load_ps(v+((LANE_VEL0+0)*SAT_SOLVER_LANES));
+	v0y = _mm256_load_ps(v+((LANE_VEL0+1)*SAT_SOLVER_LANES));
+	v0z = _mm256_load_ps(v+((LANE_VEL0+2)*SAT_SOLVER_LANES));
+	w0x = _mm256_load_ps(v+((LANE_W0+0)*SAT_SOLVER_LANES));
+	w0y = _mm256_load_ps(v+((LANE_W0+1)*SAT_SOLVER_LANES));
+	w0z = _mm256_load_ps(v+((LANE_W0+2)*SAT_SOLVER_LANES));
+	v1x = _mm256_load_ps(v+((LANE_VEL1+0)*SAT_SOLVER_LANES));
+	v1y = _mm256_load_ps(v+((LANE_VEL1+1)*SAT_SOLVER_LANES));
+	v1z = _mm256_load_ps(v+((LANE_VEL1+2)*SAT_SOLVER_LANES));
+	w1x = _mm256_load_ps(v+((LANE_W1+0)*SAT_SOLVER_LANES));
+	w1y = _mm256_load_ps(v+((LANE_W1+1)*SAT_SOLVER_LANES));
+	w1z = _mm256_load_ps(v+((LANE_W1+2)*SAT_SOLVER_LANES));
+
+	for(p = 0; p < num_passes; p++)
+	{
+		for(b = 0; b < num_blocks; b++)
+		{
+			rows = lane_rows + (b*SAT_LANE_FIELDS*SAT_SOLVER_LANES);
+			nx = _mm256_load_ps(rows+((SAT_LANE_NORMAL+0)*SAT_SOLVER_LANES));
+			ny = _mm256_load_ps(rows+((SAT_LANE_NORMAL+1)*SAT_SOLVER_LANES));
+			nz = _mm256_load_ps(rows+((SAT_LANE_NORMAL+2)*SAT_SOLVER_LANES));
+
+			//dV = v_0 + (w_0 cross r_0) - v_1 - (w_1 cross r_1)
+			rx = _mm256_load_ps(rows+((SAT_LANE_R0+0)*SAT_SOLVER_LANES));
+			ry = _mm256_load_ps(rows+((SAT_LANE_R0+1)*SAT_SOLVER_LANES));
+			rz = _mm256_load_ps(rows+((SAT_LANE_R0+2)*SAT_SOLVER_LANES));
+			dvx = _mm256_add_ps(v0x, _mm256_sub_ps(_mm256_mul_ps(w0y, rz), _mm256_mul_ps(w0z, ry)));
+			dvy = _mm256_add_ps(v0y, _mm256_sub_ps(_mm256_mul_ps(w0z, rx), _mm256_mul_ps(w0x, rz)));
+			dvz = _mm256_add_ps(v0z, _mm256_sub_ps(_mm256_mul_ps(w0x, ry), _mm256_mul_ps(w0y, rx)));
+			rx = _mm256_load_ps(rows+((SAT_LANE_R1+0)*SAT_SOLVER_LANES));
+			ry = _mm256_load_ps(rows+((SAT_LANE_R1+1)*SAT_SOLVER_LANES));
+			rz = _mm256_load_ps(rows+((SAT_LANE_R1+2)*SAT_SOLVER_LANES));
+			dvx = _mm256_sub_ps(dvx, _mm256_add_ps(v1x, _mm256_sub_ps(_mm256_mul_ps(w1y, rz), _mm256_mul_ps(w1z, ry))));
+			dvy = _mm256_sub_ps(dvy, _mm256_add_ps(v1y, _mm256_sub_ps(_mm256_mul_ps(w1z, rx), _mm256_mul_ps(w1x, rz))));
+			dvz = _mm256_sub_ps(dvz, _mm256_add_ps(v1z, _mm256_sub_ps(_mm256_mul_ps(w1x, ry), _mm256_mul_ps(w1y, rx))));
+
+			//the accumulated impulse is clamped at 0. the max keeps 'res' when the change is nan, like the scalar compare
+			dot = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dvx, nx), _mm256_mul_ps(dvy, ny)), _mm256_mul_ps(dvz, nz));
+			old_impulse = _mm256_load_ps(rows+(SAT_LANE_IMPULSE*SAT_SOLVER_LANES));
+			impulse = _mm256_add_ps(old_impulse, _mm256_mul_ps(_mm256_add_ps(_mm256_xor_ps(dot, sign_bit), _mm256_load_ps(rows+(SAT_LANE_BIAS*SAT_SOLVER_LANES))), _mm256_load_ps(rows+(SAT_LANE_INV_K*SAT_SOLVER_LANES))));
+			impulse = _mm256_blendv_ps(impulse, zero, _mm256_cmp_ps(impulse, zero, _CMP_LT_OQ));
+			_mm256_store_ps(rows+(SAT_LANE_IMPULSE*SAT_SOLVER_LANES), impulse);
+			d = _mm256_sub_ps(impulse, old_impulse);
+			res = _mm256_max_ps(_mm256_andnot_ps(sign_bit, d), res);
+
+			//the change along the normal to body 0 and the opposite one to body 1
+			m = _mm256_mul_ps(d, _mm256_load_ps(rows+(SAT_LANE_INV_MASS0*SAT_SOLVER_LANES)));
+			v0x = _mm256_add_ps(v0x, _mm256_mul_ps(m, nx));
+			v0y = _mm256_add_ps(v0y, _mm256_mul_ps(m, ny));
+			v0z = _mm256_add_ps(v0z, _mm256_mul_ps(m, nz));
+			w0x = _mm256_add_ps(w0x, _mm256_mul_ps(d, _mm256_load_ps(rows+((SAT_LANE_INV_I_RXN0+0)*SAT_SOLVER_LANES))));
+			w0y = _mm256_add_ps(w0y, _mm256_mul_ps(d, _mm256_load_ps(rows+((SAT_LANE_INV_I_RXN0+1)*SAT_SOLVER_LANES))));
+			w0z = _mm256_add_ps(w0z, _mm256_mul_ps(d, _mm256_load_ps(rows+((SAT_LANE_INV_I_RXN0+2)*SAT_SOLVER_LANES))));
+			d = _mm256_xor_ps(d, sign_bit);
+			m = _mm256_mul_ps(d, _mm256_load_ps(rows+(SAT_LANE_INV_MASS1*SAT_SOLVER_LANES)));
+			v1x = _mm256_add_ps(v1x, _mm256_mul_ps(m, nx));
+			v1y = _mm256_add_ps(v1y, _mm256_mul_ps(m, ny));
+			v1z = _mm256_add_ps(v1z, _mm256_mul_ps(m, nz));
+			w1x = _mm256_add_ps(w1x, _mm256_mul_ps(d, _mm256_load_ps(rows+((SAT_LANE_INV_I_RXN1+0)*SAT_SOLVER_LANES))));
+			w1y = _mm256_add_ps(w1y, _mm256_mul_ps(d, _mm256_load_ps(rows+((SAT_LANE_INV_I_RXN1+1)*SAT_SOLVER_LANES))));
+			w1z = _mm256_add_ps(w1z, _mm256_mul_ps(d, _mm256_load_ps(rows+((SAT_LANE_INV_I_RXN1+2)*SAT_SOLVER_LANES))));
+		}
+	}
+
+	_mm256_store_ps(v+((LANE_VEL0+0)*SAT_SOLVER_LANES), v0x);
+	_mm256_store_ps(v+((LANE_VEL0+1)*SAT_SOLVER_LANES), v0y);
+	_mm256_store_ps(v+((LANE_VEL0+2)*SAT_SOLVER_LANES), v0z);
+	_mm256_store_ps(v+((LANE_W0+0)*SAT_SOLVER_LANES), w0x);
+	_mm256_store_ps(v+((LANE_W0+1)*SAT_SOLVER_LANES), w0y);
+	_mm256_store_ps(v+((LANE_W0+2)*SAT_SOLVER_LANES), w0z);
+	_mm256_store_ps(v+((LANE_VEL1+0)*SAT_SOLVER_LANES), v1x);
+	_mm256_store_ps(v+((LANE_VEL1+1)*SAT_SOLVER_LANES), v1y);
+	_mm256_store_ps(v+((LANE_VEL1+2)*SAT_SOLVER_LANES), v1z);
+	_mm256_store_ps(v+((LANE_W1+0)*SAT_SOLVER_LANES), w1x);
+	_mm256_store_ps(v+((LANE_W1+1)*SAT_SOLVER_LANES), w1y);
+	_mm256_store_ps(v+((LANE_W1+2)*SAT_SOLVER_LANES), w1z);
+	_mm256_zeroupper();	//the scatter is sse code, which stalls on dirty upper halves
+	ScatterLaneBodies(lane_bodies, bodies, vel);
+
+	_mm256_store_ps(res_lanes, res);
+	for(k = 0; k < SAT_SOLVER_LANES; k++)
+	{
+		if(res_lanes[k] > *residual)
+			*residual = res_lanes[k];
+	}
+}
+#endif
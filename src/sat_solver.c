@@ -0,0 +1,1108 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "my_mat_math_5.h"
+#include "sat.h"
+#include "sat_trace.h"
+
+/*
+Sequential impulse solver over the contacts of all pairs of a step. The world
+inverse inertia of each body and the r vectors, effective mass and bias of each
+contact are computed once in ContactSolverBegin() and ContactSolverAddManifold().
+The iterations then only update the velocities in the solver_body_struct array,
+which are written back to the bodies at the end.
+
+Each of the num_sweeps sweeps solves every manifold once, and solving a manifold
+runs num_iterations iterations over its contacts, like ApplyCollisionImpulses()
+does for a pair. A box landing on a stack needs the impulses of its face to agree
+with each other, one iteration per sweep leaves them uneven and the stack tips.
+
+usage:
+	ContactSolverBegin(solver, bodies, num_bodies, dt);
+	for each touching pair
+		ContactSolverAddManifold(solver, i_bodyA, i_bodyB, is_b_ground, manifold);
+	ContactSolverSolve(solver);
+The manifolds have to stay where they are until ContactSolverSolve() returns.
+
+With g_solver_config.graph_coloring set the manifolds are greedily colored so no
+two manifolds of a color share a body. The ground has infinite mass and never
+gets impulses, so it doesn't count. Each sweep goes through the colors in
+order and the manifolds of a color are spread over the thread pool. Since they
+don't touch the same bodies the result doesn't depend on the number of threads.
+
+With g_solver_config.lane_solver set as well, the rows of each color are copied
+into lane groups of SAT_SOLVER_LANES manifolds after the warm start. Block j of a
+group holds contact j of each of its manifolds as structure-of-arrays rows, lanes
+of manifolds with fewer contacts get no impulse. SolveContactLanes() solves a group
+with the simd kernels of sat_simd.c and gives the same impulses as SolveContact().
+The last batch, whose manifolds may share bodies, is always solved row by row.
+
+With g_solver_config.block_solver set, each sweep solves the 2 to 4 contacts
+of a manifold together instead of iterating over them: the accumulated impulses x
+of the manifold must satisfy x >= 0, w = A*x + b >= 0 and x_i*w_i = 0, where w is
+the approach velocity past the bias. SolveBlock() tries the sets of active contacts
+from the largest down and takes the first one whose solution fits. The 4 contacts
+of a face only have 3 degrees of freedom, so their full set is singular and gets
+skipped. If no set fits the rows are solved one by one. The block solver doesn't
+run in lanes.
+
+With g_solver_config.split_impulse set, the velocity rows get no Baumgarte bias.
+After the velocity sweeps, split_iterations more sweeps go through the same batches
+and solve the contacts again on pseudo velocities that start at zero, with
+CalcSplitBias() as the target. The pseudo velocities are handed to the bodies and
+only move them in UpdateBoxSimulation(), so pushing out penetration doesn't leave
+energy in the real velocities.
+*/
+
+static void SolveContact(struct solver_body_struct * bodies, struct solver_contact_struct * row, float * residual);
+static void ApplySolverImpulse(struct solver_body_struct * bodies, struct solver_contact_struct * row, float impulse);
+static void SolveSplitContact(struct solver_body_struct * bodies, struct solver_contact_struct * row, float * residual);
+static void ColorManifolds(struct contact_solver_struct * solver);
+static float SolveBatch(struct contact_solver_struct * solver, int i_batch);
+static void SolveBatchJob(void * user, int i_task);
+static int SolveBlock(struct solver_body_struct * bodies, struct solver_contact_struct * rows, int num_rows, float * residual);
+static int SolveLinearSystem(double * a, double * b, int n, double pivot_epsilon);
+static int BuildLaneGroups(struct contact_solver_struct * solver);
+static void FillLaneGroup(struct contact_solver_struct * solver, int * manifolds, int num_manifolds, int i_group);
+static int ContactSolverReserveManifolds(struct contact_solver_struct * solver, int num_manifolds);
+static int ContactSolverReserveLanes(struct contact_solver_struct * solver, int num_groups, int num_blocks);
+
+void ContactSolverInit(struct contact_solver_struct * solver, struct thread_pool_struct * pool)
+{
+	memset(solver, 0, sizeof(struct contact_solver_struct));
+	solver->pool = pool;
+}
+
+void ContactSolverFree(struct contact_solver_struct * solver)
+{
+	free(solver->solver_bodies);
+	free(solver->body_colors);
+	free(solver->contacts);
+	free(solver->manifold_rows);
+	free(solver->manifold_bodies);
+	free(solver->manifold_colors);
+	free(solver->batch_manifolds);
+	free(solver->batch_first);
+	free(solver->task_residuals);
+	free(solver->task_fallbacks);
+	free(solver->lane_rows);
+	free(solver->lane_contacts);
+	free(solver->group_blocks);
+	free(solver->group_bodies);
+	free(solver->batch_groups);
+	memset(solver, 0, sizeof(struct contact_solver_struct));
+}
+
+/*
+Starts a new step of 'dt' seconds. Copies the velocities of the bodies and rotates
+their inverse inertia into world space.
+returns 0 on failure.
+*/
+int ContactSolverBegin(struct contact_solver_struct * solver, struct box_struct ** bodies, int num_bodies, float dt)
+{
+	struct solver_body_struct * new_bodies;
+	struct solver_body_struct * sbody;
+	struct box_struct * box;
+	uint64_t * new_colors;
+	float iorient[9];
+	int num_tasks;
+	int i;
+
+	if(num_bodies > solver->max_bodies)
+	{
+		new_bodies = (struct solver_body_struct*)realloc(solver->solver_bodies, num_bodies*sizeof(struct solver_body_struct));
+		if(new_bodies != 0)
+			solver->solver_bodies = new_bodies;
+		new_colors = (uint64_t*)realloc(solver->body_colors, num_bodies*sizeof(uint64_t));
+		if(new_colors != 0)
+			solver->body_colors = new_colors;
+		if(new_bodies == 0 || new_colors == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		solver->max_bodies = num_bodies;
+	}
+
+	//a few tasks per thread so uneven batches still balance
+	num_tasks = 1;
+	if(solver->pool != 0)
+		num_tasks = 4*solver->pool->num_threads;
+	if(num_tasks > solver->max_tasks)
+	{
+		free(solver->task_residuals);
+		free(solver->task_fallbacks);
+		solver->task_residuals = (float*)malloc(num_tasks*sizeof(float));
+		solver->task_fallbacks = (int*)malloc(num_tasks*sizeof(int));
+		if(solver->task_residuals == 0 || solver->task_fallbacks == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			solver->max_tasks = 0;
+			return 0;
+		}
+		solver->max_tasks = num_tasks;
+	}
+	solver->bodies = bodies;
+	solver->dt = dt;
+	solver->num_bodies = num_bodies;
+	solver->num_contacts = 0;
+	solver->num_manifolds = 0;
+
+	for(i = 0; i < num_bodies; i++)
+	{
+		box = bodies[i];
+		sbody = solver->solver_bodies+i;
+
+		//I_i^-1 = (R_i)*(I_0^-1)*(R_i^-1)
+		memcpy(iorient, box->orientation, (9*sizeof(float)));
+		mmTranspose3x3(iorient);
+		mmMultiplyMatrix3x3(box->imomentOfInertia, iorient, sbody->inv_inertia);
+		mmMultiplyMatrix3x3(box->orientation, sbody->inv_inertia, sbody->inv_inertia);
+
+		sbody->inv_mass = (box->mass > 0.0f) ? (1.0f/box->mass) : 0.0f;
+		memcpy(sbody->linear_vel, box->linearVel, 3*sizeof(float));
+		memcpy(sbody->angular_vel, box->angularVel, 3*sizeof(float));
+		memcpy(sbody->angular_momentum, box->angularMomentum, 3*sizeof(float));
+		memset(sbody->split_linear_vel, 0, 3*sizeof(float));
+		memset(sbody->split_angular_vel, 0, 3*sizeof(float));
+		sbody->is_used = 0;
+	}
+
+	return 1;
+}
+
+/*
+Adds a contact row for every contact of 'manifold'. With is_b_ground set body B
+gets no impulses.
+returns 0 on failure.
+*/
+int ContactSolverAddManifold(struct contact_solver_struct * solver, int i_bodyA, int i_bodyB, int is_b_ground, struct contact_manifold_struct * manifold)
+{
+	struct solver_contact_struct * new_contacts;
+	struct solver_contact_struct * row;
+	struct solver_body_struct * sbody;
+	struct contact_info_struct * contact;
+	struct box_struct * box;
+	float k;
+	int new_max;
+	int i;
+	int j;
+	int r;
+
+	r = ContactSolverReserveManifolds(solver, solver->num_manifolds+1);
+	if(r == 0)
+		return 0;
+	if(solver->num_contacts+manifold->num_contacts > solver->max_contacts)
+	{
+		new_max = (solver->max_contacts > 0) ? (solver->max_contacts*2) : 256;
+		while(new_max < solver->num_contacts+manifold->num_contacts)
+		{
+			new_max *= 2;
+		}
+		new_contacts = (struct solver_contact_struct*)realloc(solver->contacts, new_max*sizeof(struct solver_contact_struct));
+		if(new_contacts == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		solver->contacts = new_contacts;
+		solver->max_contacts = new_max;
+	}
+
+	solver->manifold_rows[solver->num_manifolds] = solver->num_contacts;
+	solver->manifold_bodies[(solver->num_manifolds*2)] = i_bodyA;
+	solver->manifold_bodies[(solver->num_manifolds*2)+1] = (is_b_ground == 1) ? -1 : i_bodyB;
+	for(i = 0; i < manifold->num_contacts; i++)
+	{
+		contact = manifold->contacts+i;
+		row = solver->contacts+solver->num_contacts;
+		row->i_body[0] = i_bodyA;
+		row->i_body[1] = (is_b_ground == 1) ? -1 : i_bodyB;
+		memcpy(row->normal, contact->normal, 3*sizeof(float));
+
+		//k_n = (1/m_1) + (1/m_2) + ((r1 cross n) dot I_1^-1*(r1 cross n)) + ((r2 cross n) dot I_2^-1*(r2 cross n))
+		k = 0.0f;
+		for(j = 0; j < 2; j++)
+		{
+			if(row->i_body[j] == -1)
+			{
+				memset(row->r[j], 0, 3*sizeof(float));
+				memset(row->rxn[j], 0, 3*sizeof(float));
+				memset(row->inv_i_rxn[j], 0, 3*sizeof(float));
+				continue;
+			}
+			box = solver->bodies[row->i_body[j]];
+			sbody = solver->solver_bodies+row->i_body[j];
+			sbody->is_used = 1;
+			vSubtract(row->r[j], contact->point, box->pos);
+			vCrossProduct(row->rxn[j], row->r[j], row->normal);
+			memcpy(row->inv_i_rxn[j], row->rxn[j], 3*sizeof(float));
+			mmTransformVec3(sbody->inv_inertia, row->inv_i_rxn[j]);
+			k += sbody->inv_mass + vDotProduct(row->rxn[j], row->inv_i_rxn[j]);
+		}
+		row->inv_k = (k > 0.0f) ? (1.0f/k) : 0.0f;
+		row->bias = 0.0f;
+		row->split_bias = 0.0f;
+		if(g_solver_config.split_impulse == 1)
+			row->split_bias = CalcSplitBias(contact->penetration, solver->dt);
+		else
+			row->bias = CalcBaumgarteBias(contact->penetration, g_solver_config.bias_factor, solver->dt);
+		row->impulse = 0.0f;
+		row->split_impulse = 0.0f;
+		row->contact = contact;
+		solver->num_contacts += 1;
+	}
+	solver->num_manifolds += 1;
+	solver->manifold_rows[solver->num_manifolds] = solver->num_contacts;
+
+	return 1;
+}
+
+//iterates over all contact rows and writes the new velocities back to the bodies
+void ContactSolverSolve(struct contact_solver_struct * solver)
+{
+	struct solver_body_struct * sbody;
+	struct solver_contact_struct * row;
+	struct box_struct * box;
+	float * rows;
+	float sign;
+	float residual = 0.0f;
+	float batch_residual;
+	int num_batches;
+	int i;
+	int k;
+	int c;
+	int j;
+	int l;
+
+	if(solver->num_manifolds == 0)
+		return;
+
+	//without colors everything is one batch, solved in the order the manifolds were added
+	if(g_solver_config.graph_coloring == 1)
+	{
+		ColorManifolds(solver);
+	}
+	else
+	{
+		for(i = 0; i < solver->num_manifolds; i++)
+		{
+			solver->batch_manifolds[i] = i;
+		}
+		solver->batch_first[0] = 0;
+		solver->batch_first[1] = solver->num_manifolds;
+		solver->num_batches = 1;
+	}
+	num_batches = solver->num_batches;
+
+	//warm start: apply the impulses the contacts ended the last step with
+	if(g_solver_config.warm_start == 1)
+	{
+		for(i = 0; i < solver->num_contacts; i++)
+		{
+			solver->contacts[i].impulse = solver->contacts[i].contact->normal_impulse;
+			ApplySolverImpulse(solver->solver_bodies, (solver->contacts+i), solver->contacts[i].impulse);
+		}
+	}
+
+	//the lane blocks start from the rows' impulses
+	solver->use_lanes = 0;
+	if(g_solver_config.lane_solver == 1 && g_solver_config.block_solver == 0 && g_solver_config.graph_coloring == 1 && SatGetSimdLevel() > SAT_SIMD_SCALAR)
+		solver->use_lanes = BuildLaneGroups(solver);
+
+	for(k = 0; k < g_solver_config.num_sweeps; k++)
+	{
+		residual = 0.0f;
+		for(c = 0; c < num_batches; c++)
+		{
+			batch_residual = SolveBatch(solver, c);
+			if(batch_residual > residual)
+				residual = batch_residual;
+		}
+		if(g_solver_config.residual_tolerance > 0.0f && residual <= g_solver_config.residual_tolerance)
+		{
+			g_solver_stats.num_converged += solver->num_manifolds;
+			k += 1;
+			break;
+		}
+	}
+	g_solver_stats.num_solves += solver->num_manifolds;
+	g_solver_stats.num_iterations += k*g_solver_config.num_iterations*solver->num_manifolds;
+	if(residual > g_solver_stats.max_residual)
+		g_solver_stats.max_residual = residual;
+	SAT_DEBUG("solver: %d contacts of %d manifolds in %d batches, sweeps=%d residual=%g", solver->num_contacts, solver->num_manifolds, num_batches, k, residual);
+
+	//the pseudo velocities start from zero every step, there is nothing to warm start them with
+	if(g_solver_config.split_impulse == 1)
+	{
+		solver->split_pass = 1;
+		for(k = 0; k < g_solver_config.split_iterations; k++)
+		{
+			for(c = 0; c < num_batches; c++)
+			{
+				SolveBatch(solver, c);
+			}
+		}
+		solver->split_pass = 0;
+	}
+
+	if(solver->use_lanes == 1)
+	{
+		for(i = 0; i < solver->num_blocks; i++)
+		{
+			rows = solver->lane_rows + (i*SAT_LANE_FIELDS*SAT_SOLVER_LANES);
+			for(l = 0; l < SAT_SOLVER_LANES; l++)
+			{
+				if(solver->lane_contacts[(i*SAT_SOLVER_LANES)+l] != -1)
+					solver->contacts[solver->lane_contacts[(i*SAT_SOLVER_LANES)+l]].impulse = rows[(SAT_LANE_IMPULSE*SAT_SOLVER_LANES)+l];
+			}
+		}
+	}
+
+	//keep the impulses for the next step. the angular momentum doesn't feed back into
+	//the iterations, so it only gets the total impulse of each contact
+	for(i = 0; i < solver->num_contacts; i++)
+	{
+		row = solver->contacts+i;
+		row->contact->normal_impulse = row->impulse;
+		sign = 1.0f;
+		for(j = 0; j < 2; j++)
+		{
+			if(row->i_body[j] != -1)
+			{
+				sbody = solver->solver_bodies+row->i_body[j];
+				sbody->angular_momentum[0] += sign*row->impulse*row->rxn[j][0];
+				sbody->angular_momentum[1] += sign*row->impulse*row->rxn[j][1];
+				sbody->angular_momentum[2] += sign*row->impulse*row->rxn[j][2];
+			}
+			sign = -1.0f;
+		}
+	}
+
+	for(i = 0; i < solver->num_bodies; i++)
+	{
+		sbody = solver->solver_bodies+i;
+		if(sbody->is_used == 0)
+			continue;
+		box = solver->bodies[i];
+		memcpy(box->linearVel, sbody->linear_vel, 3*sizeof(float));
+		memcpy(box->newLinearVel, sbody->linear_vel, 3*sizeof(float));
+		memcpy(box->angularVel, sbody->angular_vel, 3*sizeof(float));
+		memcpy(box->newAngularVelQ, sbody->angular_vel, 3*sizeof(float));
+		box->newAngularVelQ[3] = 0.0f;
+		memcpy(box->angularMomentum, sbody->angular_momentum, 3*sizeof(float));
+		memcpy(box->newAngularMomentum, sbody->angular_momentum, 3*sizeof(float));
+		memcpy(box->splitLinearVel, sbody->split_linear_vel, 3*sizeof(float));
+		memcpy(box->splitAngularVel, sbody->split_angular_vel, 3*sizeof(float));
+	}
+}
+
+/*
+Greedy coloring: each manifold gets the lowest color that no earlier manifold of
+its bodies has. Fills the batch arrays with the manifolds sorted by color, the ones
+that found no free color go in a last batch that is solved on one thread.
+*/
+static void ColorManifolds(struct contact_solver_struct * solver)
+{
+	uint64_t used;
+	int i_body;
+	int c;
+	int i;
+	int j;
+
+	memset(solver->body_colors, 0, solver->num_bodies*sizeof(uint64_t));
+	memset(solver->batch_first, 0, (SAT_SOLVER_MAX_COLORS+2)*sizeof(int));
+	solver->num_batches = 0;
+	for(i = 0; i < solver->num_manifolds; i++)
+	{
+		used = 0;
+		for(j = 0; j < 2; j++)
+		{
+			i_body = solver->manifold_bodies[(i*2)+j];
+			if(i_body != -1)
+				used |= solver->body_colors[i_body];
+		}
+		c = SAT_SOLVER_MAX_COLORS;
+		if(used != ~((uint64_t)0))
+			c = __builtin_ctzll(~used);
+		if(c < SAT_SOLVER_MAX_COLORS)
+		{
+			for(j = 0; j < 2; j++)
+			{
+				i_body = solver->manifold_bodies[(i*2)+j];
+				if(i_body != -1)
+					solver->body_colors[i_body] |= ((uint64_t)1 << c);
+			}
+		}
+		solver->manifold_colors[i] = c;
+		solver->batch_first[c+1] += 1;	//count of color c
+		if(c+1 > solver->num_batches)
+			solver->num_batches = c+1;
+	}
+
+	//counting sort by color, manifolds keep the order they were added in
+	for(c = 0; c < solver->num_batches; c++)
+	{
+		solver->batch_first[c+1] += solver->batch_first[c];
+	}
+	for(i = 0; i < solver->num_manifolds; i++)
+	{
+		c = solver->manifold_colors[i];
+		solver->batch_manifolds[solver->batch_first[c]] = i;
+		solver->batch_first[c] += 1;
+	}
+	for(c = solver->num_batches; c > 0; c--)
+	{
+		solver->batch_first[c] = solver->batch_first[c-1];
+	}
+	solver->batch_first[0] = 0;
+}
+
+/*
+Runs one iteration over the manifolds of a batch. Batches below the last one are
+split over the thread pool.
+returns the largest impulse change.
+*/
+static float SolveBatch(struct contact_solver_struct * solver, int i_batch)
+{
+	float residual;
+	int num_manifolds;
+	int num_tasks;
+	int t;
+
+	num_manifolds = solver->batch_first[i_batch+1] - solver->batch_first[i_batch];
+	num_tasks = num_manifolds/SAT_SOLVER_TASK_MANIFOLDS;
+	if(num_tasks > solver->max_tasks)
+		num_tasks = solver->max_tasks;
+	if(num_tasks < 1 || i_batch == SAT_SOLVER_MAX_COLORS || g_solver_config.graph_coloring == 0)
+		num_tasks = 1;
+
+	solver->i_batch = i_batch;
+	solver->num_tasks = num_tasks;
+	ThreadPoolRun(solver->pool, SolveBatchJob, solver, num_tasks);
+
+	residual = 0.0f;
+	for(t = 0; t < num_tasks; t++)
+	{
+		if(solver->task_residuals[t] > residual)
+			residual = solver->task_residuals[t];
+		g_solver_stats.num_block_fallbacks += solver->task_fallbacks[t];
+	}
+
+	return residual;
+}
+
+static void SolveBatchJob(void * user, int i_task)
+{
+	struct contact_solver_struct * solver;
+	float residual = 0.0f;
+	int * manifolds;
+	int fallbacks = 0;
+	int first;
+	int num_rows;
+	int r;
+	int i_start;
+	int i_end;
+	int i;
+	int j;
+	int p;
+
+	solver = (struct contact_solver_struct*)user;
+	if(solver->use_lanes == 1 && solver->split_pass == 0 && solver->i_batch < SAT_SOLVER_MAX_COLORS)
+	{
+		GetTaskRange((solver->batch_groups[solver->i_batch+1] - solver->batch_groups[solver->i_batch]), solver->num_tasks, i_task, &i_start, &i_end);
+		for(i = solver->batch_groups[solver->i_batch]+i_start; i < solver->batch_groups[solver->i_batch]+i_end; i++)
+		{
+			SolveContactLanes((solver->lane_rows + (solver->group_blocks[i]*SAT_LANE_FIELDS*SAT_SOLVER_LANES)), (solver->group_blocks[i+1] - solver->group_blocks[i]),
+				g_solver_config.num_iterations, (solver->group_bodies + (i*2*SAT_SOLVER_LANES)), solver->solver_bodies, &residual);
+		}
+		solver->task_residuals[i_task] = residual;
+		solver->task_fallbacks[i_task] = 0;
+		return;
+	}
+	manifolds = solver->batch_manifolds + solver->batch_first[solver->i_batch];
+	GetTaskRange((solver->batch_first[solver->i_batch+1] - solver->batch_first[solver->i_batch]), solver->num_tasks, i_task, &i_start, &i_end);
+	for(i = i_start; i < i_end; i++)
+	{
+		first = solver->manifold_rows[manifolds[i]];
+		num_rows = solver->manifold_rows[manifolds[i]+1] - first;
+		if(g_solver_config.block_solver == 1 && solver->split_pass == 0 && num_rows > 1)
+		{
+			r = SolveBlock(solver->solver_bodies, (solver->contacts+first), num_rows, &residual);
+			if(r == 1)
+				continue;
+			fallbacks += 1;
+		}
+
+		//like the pair solver, the contacts of a manifold settle among themselves before the next manifold
+		for(p = 0; p < g_solver_config.num_iterations; p++)
+		{
+			for(j = first; j < first+num_rows; j++)
+			{
+				if(solver->split_pass == 1)
+					SolveSplitContact(solver->solver_bodies, (solver->contacts+j), &residual);
+				else
+					SolveContact(solver->solver_bodies, (solver->contacts+j), &residual);
+			}
+		}
+	}
+	solver->task_residuals[i_task] = residual;
+	solver->task_fallbacks[i_task] = fallbacks;
+}
+
+/*
+Copies the rows of the colored batches into lane groups. A group gets one block
+per contact of its largest manifold.
+returns 0 if there is no memory for the blocks, the rows are solved one by one then.
+*/
+static int BuildLaneGroups(struct contact_solver_struct * solver)
+{
+	int num_groups;
+	int num_blocks;
+	int num_manifolds;
+	int num_slots;
+	int m;
+	int c;
+	int i;
+	int l;
+	int r;
+
+	//count the groups and blocks
+	num_groups = 0;
+	num_blocks = 0;
+	for(c = 0; c < solver->num_batches && c < SAT_SOLVER_MAX_COLORS; c++)
+	{
+		for(i = solver->batch_first[c]; i < solver->batch_first[c+1]; i += SAT_SOLVER_LANES)
+		{
+			num_manifolds = solver->batch_first[c+1] - i;
+			if(num_manifolds > SAT_SOLVER_LANES)
+				num_manifolds = SAT_SOLVER_LANES;
+			num_slots = 0;
+			for(l = 0; l < num_manifolds; l++)
+			{
+				m = solver->batch_manifolds[i+l];
+				if(solver->manifold_rows[m+1] - solver->manifold_rows[m] > num_slots)
+					num_slots = solver->manifold_rows[m+1] - solver->manifold_rows[m];
+			}
+			num_groups += 1;
+			num_blocks += num_slots;
+		}
+	}
+	if(num_groups == 0)
+		return 0;
+	r = ContactSolverReserveLanes(solver, num_groups, num_blocks);
+	if(r == 0)
+		return 0;
+
+	num_groups = 0;
+	solver->group_blocks[0] = 0;
+	for(c = 0; c < solver->num_batches && c < SAT_SOLVER_MAX_COLORS; c++)
+	{
+		solver->batch_groups[c] = num_groups;
+		for(i = solver->batch_first[c]; i < solver->batch_first[c+1]; i += SAT_SOLVER_LANES)
+		{
+			num_manifolds = solver->batch_first[c+1] - i;
+			if(num_manifolds > SAT_SOLVER_LANES)
+				num_manifolds = SAT_SOLVER_LANES;
+			FillLaneGroup(solver, (solver->batch_manifolds+i), num_manifolds, num_groups);
+			num_groups += 1;
+		}
+	}
+	solver->batch_groups[c] = num_groups;
+	solver->num_groups = num_groups;
+	solver->num_blocks = num_blocks;
+
+	return 1;
+}
+
+//fills group 'i_group' from 'manifolds' and sets where the next group starts
+static void FillLaneGroup(struct contact_solver_struct * solver, int * manifolds, int num_manifolds, int i_group)
+{
+	struct solver_contact_struct * row;
+	float * rows;
+	int * bodies;
+	int num_slots;
+	int i_row;
+	int m;
+	int b;
+	int j;
+	int k;
+	int l;
+
+	//empty lanes keep the ground as both bodies, so they read zero velocities and are never written back
+	bodies = solver->group_bodies + (i_group*2*SAT_SOLVER_LANES);
+	num_slots = 0;
+	for(l = 0; l < SAT_SOLVER_LANES; l++)
+	{
+		bodies[l] = -1;
+		bodies[SAT_SOLVER_LANES+l] = -1;
+		if(l >= num_manifolds)
+			continue;
+		m = manifolds[l];
+		bodies[l] = solver->manifold_bodies[(m*2)];
+		bodies[SAT_SOLVER_LANES+l] = solver->manifold_bodies[(m*2)+1];
+		if(solver->manifold_rows[m+1] - solver->manifold_rows[m] > num_slots)
+			num_slots = solver->manifold_rows[m+1] - solver->manifold_rows[m];
+	}
+	solver->group_blocks[i_group+1] = solver->group_blocks[i_group] + num_slots;
+
+	//lanes past the end of their manifold have inv_k 0, so their impulse stays 0 and the velocities don't change
+	for(b = 0; b < num_slots; b++)
+	{
+		rows = solver->lane_rows + ((solver->group_blocks[i_group]+b)*SAT_LANE_FIELDS*SAT_SOLVER_LANES);
+		memset(rows, 0, SAT_LANE_FIELDS*SAT_SOLVER_LANES*sizeof(float));
+		for(l = 0; l < SAT_SOLVER_LANES; l++)
+		{
+			i_row = -1;
+			if(l < num_manifolds && solver->manifold_rows[manifolds[l]]+b < solver->manifold_rows[manifolds[l]+1])
+				i_row = solver->manifold_rows[manifolds[l]]+b;
+			solver->lane_contacts[((solver->group_blocks[i_group]+b)*SAT_SOLVER_LANES)+l] = i_row;
+			if(i_row == -1)
+				continue;
+
+			row = solver->contacts+i_row;
+			for(k = 0; k < 3; k++)
+			{
+				rows[((SAT_LANE_NORMAL+k)*SAT_SOLVER_LANES)+l] = row->normal[k];
+				for(j = 0; j < 2; j++)
+				{
+					rows[(((j*3)+SAT_LANE_R0+k)*SAT_SOLVER_LANES)+l] = row->r[j][k];
+					rows[(((j*3)+SAT_LANE_INV_I_RXN0+k)*SAT_SOLVER_LANES)+l] = row->inv_i_rxn[j][k];
+				}
+			}
+			for(j = 0; j < 2; j++)
+			{
+				if(row->i_body[j] != -1)
+					rows[((SAT_LANE_INV_MASS0+j)*SAT_SOLVER_LANES)+l] = solver->solver_bodies[row->i_body[j]].inv_mass;
+			}
+			rows[(SAT_LANE_INV_K*SAT_SOLVER_LANES)+l] = row->inv_k;
+			rows[(SAT_LANE_BIAS*SAT_SOLVER_LANES)+l] = row->bias;
+			rows[(SAT_LANE_IMPULSE*SAT_SOLVER_LANES)+l] = row->impulse;
+		}
+	}
+}
+
+//makes room for 'num_manifolds' manifolds
+static int ContactSolverReserveManifolds(struct contact_solver_struct * solver, int num_manifolds)
+{
+	int * new_rows;
+	int * new_bodies;
+	int * new_colors;
+	int * new_batches;
+	int new_max;
+
+	if(solver->batch_first == 0)
+	{
+		solver->batch_first = (int*)malloc((SAT_SOLVER_MAX_COLORS+2)*sizeof(int));
+		solver->batch_groups = (int*)malloc((SAT_SOLVER_MAX_COLORS+2)*sizeof(int));
+		if(solver->batch_first == 0 || solver->batch_groups == 0)
+		{
+			free(solver->batch_first);
+			free(solver->batch_groups);
+			solver->batch_first = 0;
+			solver->batch_groups = 0;
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+	}
+	if(num_manifolds <= solver->max_manifolds)
+		return 1;
+
+	new_max = (solver->max_manifolds > 0) ? (solver->max_manifolds*2) : 64;
+	while(new_max < num_manifolds)
+	{
+		new_max *= 2;
+	}
+	new_rows = (int*)realloc(solver->manifold_rows, (new_max+1)*sizeof(int));
+	if(new_rows != 0)
+		solver->manifold_rows = new_rows;
+	new_bodies = (int*)realloc(solver->manifold_bodies, new_max*2*sizeof(int));
+	if(new_bodies != 0)
+		solver->manifold_bodies = new_bodies;
+	new_colors = (int*)realloc(solver->manifold_colors, new_max*sizeof(int));
+	if(new_colors != 0)
+		solver->manifold_colors = new_colors;
+	new_batches = (int*)realloc(solver->batch_manifolds, new_max*sizeof(int));
+	if(new_batches != 0)
+		solver->batch_manifolds = new_batches;
+	if(new_rows == 0 || new_bodies == 0 || new_colors == 0 || new_batches == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		return 0;
+	}
+	solver->max_manifolds = new_max;
+
+	return 1;
+}
+
+//makes room for 'num_groups' lane groups with 'num_blocks' blocks in all. the blocks are aligned for the avx2 kernel.
+static int ContactSolverReserveLanes(struct contact_solver_struct * solver, int num_groups, int num_blocks)
+{
+	void * mem = 0;
+	int * new_contacts;
+	int * new_blocks;
+	int * new_bodies;
+	int new_max;
+	int r;
+
+	if(num_blocks > solver->max_blocks)
+	{
+		new_max = (solver->max_blocks > 0) ? (solver->max_blocks*2) : 64;
+		while(new_max < num_blocks)
+		{
+			new_max *= 2;
+		}
+		//the blocks are filled again every step, so they don't have to be copied
+		free(solver->lane_rows);
+		solver->lane_rows = 0;
+		solver->max_blocks = 0;
+		r = posix_memalign(&mem, (SAT_SOLVER_LANES*sizeof(float)), (new_max*SAT_LANE_FIELDS*SAT_SOLVER_LANES*sizeof(float)));
+		if(r != 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		solver->lane_rows = (float*)mem;
+		new_contacts = (int*)realloc(solver->lane_contacts, new_max*SAT_SOLVER_LANES*sizeof(int));
+		if(new_contacts == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		solver->lane_contacts = new_contacts;
+		solver->max_blocks = new_max;
+	}
+
+	if(num_groups > solver->max_groups)
+	{
+		new_max = (solver->max_groups > 0) ? (solver->max_groups*2) : 16;
+		while(new_max < num_groups)
+		{
+			new_max *= 2;
+		}
+		new_blocks = (int*)realloc(solver->group_blocks, (new_max+1)*sizeof(int));
+		if(new_blocks != 0)
+			solver->group_blocks = new_blocks;
+		new_bodies = (int*)realloc(solver->group_bodies, new_max*2*SAT_SOLVER_LANES*sizeof(int));
+		if(new_bodies != 0)
+			solver->group_bodies = new_bodies;
+		if(new_blocks == 0 || new_bodies == 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			return 0;
+		}
+		solver->max_groups = new_max;
+	}
+
+	return 1;
+}
+
+//max[ (-dV dot n + v_bias)/k_n , 0] with the accumulated impulse clamped at 0
+static void SolveContact(struct solver_body_struct * bodies, struct solver_contact_struct * row, float * residual)
+{
+	struct solver_body_struct * sbody;
+	float delta_vel[3];
+	float cross_vec[3];
+	float old_impulse;
+	float sign;
+	int j;
+
+	//dV = v_1 + (w_1 cross r_1) - v_2 - (w_2 cross r_2)
+	memset(delta_vel, 0, 3*sizeof(float));
+	sign = 1.0f;
+	for(j = 0; j < 2; j++)
+	{
+		if(row->i_body[j] != -1)
+		{
+			sbody = bodies+row->i_body[j];
+			vCrossProduct(cross_vec, sbody->angular_vel, row->r[j]);
+			delta_vel[0] += sign*(sbody->linear_vel[0] + cross_vec[0]);
+			delta_vel[1] += sign*(sbody->linear_vel[1] + cross_vec[1]);
+			delta_vel[2] += sign*(sbody->linear_vel[2] + cross_vec[2]);
+		}
+		sign = -1.0f;
+	}
+
+	old_impulse = row->impulse;
+	row->impulse += ((-1.0f*vDotProduct(delta_vel, row->normal)) + row->bias)*row->inv_k;
+	if(row->impulse < 0.0f)
+		row->impulse = 0.0f;
+	if(fabs(row->impulse - old_impulse) > *residual)
+		*residual = fabs(row->impulse - old_impulse);
+
+	ApplySolverImpulse(bodies, row, (row->impulse - old_impulse));
+}
+
+//applies 'impulse' along the normal to the velocities of body 0 and the opposite one to body 1
+static void ApplySolverImpulse(struct solver_body_struct * bodies, struct solver_contact_struct * row, float impulse)
+{
+	struct solver_body_struct * sbody;
+	float sign;
+	int j;
+	int k;
+
+	sign = 1.0f;
+	for(j = 0; j < 2; j++)
+	{
+		if(row->i_body[j] != -1)
+		{
+			sbody = bodies+row->i_body[j];
+			for(k = 0; k < 3; k++)
+			{
+				sbody->linear_vel[k] += sign*impulse*sbody->inv_mass*row->normal[k];
+				sbody->angular_vel[k] += sign*impulse*row->inv_i_rxn[j][k];
+			}
+		}
+		sign = -1.0f;
+	}
+}
+
+//SolveContact() on the pseudo velocities, with the split bias as the target
+static void SolveSplitContact(struct solver_body_struct * bodies, struct solver_contact_struct * row, float * residual)
+{
+	struct solver_body_struct * sbody;
+	float delta_vel[3];
+	float cross_vec[3];
+	float old_impulse;
+	float impulse;
+	float sign;
+	int j;
+	int k;
+
+	memset(delta_vel, 0, 3*sizeof(float));
+	sign = 1.0f;
+	for(j = 0; j < 2; j++)
+	{
+		if(row->i_body[j] != -1)
+		{
+			sbody = bodies+row->i_body[j];
+			vCrossProduct(cross_vec, sbody->split_angular_vel, row->r[j]);
+			delta_vel[0] += sign*(sbody->split_linear_vel[0] + cross_vec[0]);
+			delta_vel[1] += sign*(sbody->split_linear_vel[1] + cross_vec[1]);
+			delta_vel[2] += sign*(sbody->split_linear_vel[2] + cross_vec[2]);
+		}
+		sign = -1.0f;
+	}
+
+	old_impulse = row->split_impulse;
+	row->split_impulse += ((-1.0f*vDotProduct(delta_vel, row->normal)) + row->split_bias)*row->inv_k;
+	if(row->split_impulse < 0.0f)
+		row->split_impulse = 0.0f;
+	impulse = row->split_impulse - old_impulse;
+	if(fabsf(impulse) > *residual)
+		*residual = fabsf(impulse);
+
+	sign = 1.0f;
+	for(j = 0; j < 2; j++)
+	{
+		if(row->i_body[j] != -1)
+		{
+			sbody = bodies+row->i_body[j];
+			for(k = 0; k < 3; k++)
+			{
+				sbody->split_linear_vel[k] += sign*impulse*sbody->inv_mass*row->normal[k];
+				sbody->split_angular_vel[k] += sign*impulse*row->inv_i_rxn[j][k];
+			}
+		}
+		sign = -1.0f;
+	}
+}
+
+/*
+Solves the normal impulses of the 'num_rows' contacts of a manifold together, at
+most 4 of them.
+returns 0 if no set of active contacts fits. Nothing is changed then.
+*/
+static int SolveBlock(struct solver_body_struct * bodies, struct solver_contact_struct * rows, int num_rows, float * residual)
+{
+	struct solver_body_struct * sbody;
+	float a[16];	//A_ij = change of the normal velocity of contact i per unit impulse at contact j
+	float b[4];
+	double a_set[16];
+	double x_set[4];
+	float x[4];
+	float delta_vel[3];
+	float cross_vec[3];
+	float sign;
+	float vel;
+	float max_k = 0.0f;
+	float max_b = 0.0f;
+	float impulse;
+	int index[4];	//rows of the active contacts
+	int num_active;
+	int set;
+	int i;
+	int j;
+	int k;
+	int r;
+
+	for(i = 0; i < num_rows; i++)
+	{
+		for(j = 0; j < num_rows; j++)
+		{
+			a[(i*4)+j] = 0.0f;
+			for(k = 0; k < 2; k++)
+			{
+				if(rows[i].i_body[k] == -1)
+					continue;
+				a[(i*4)+j] += (bodies[rows[i].i_body[k]].inv_mass*vDotProduct(rows[i].normal, rows[j].normal)) + vDotProduct(rows[i].rxn[k], rows[j].inv_i_rxn[k]);
+			}
+		}
+		if(a[(i*4)+i] > max_k)
+			max_k = a[(i*4)+i];
+	}
+	for(i = 0; i < num_rows; i++)
+	{
+		a[(i*4)+i] += SAT_BLOCK_REGULARIZATION*a[(i*4)+i];
+	}
+
+	//b_i = dV_i dot n_i - v_bias_i - (A*impulse)_i, the approach velocity without the impulses applied so far
+	for(i = 0; i < num_rows; i++)
+	{
+		memset(delta_vel, 0, 3*sizeof(float));
+		sign = 1.0f;
+		for(k = 0; k < 2; k++)
+		{
+			if(rows[i].i_body[k] != -1)
+			{
+				sbody = bodies+rows[i].i_body[k];
+				vCrossProduct(cross_vec, sbody->angular_vel, rows[i].r[k]);
+				delta_vel[0] += sign*(sbody->linear_vel[0] + cross_vec[0]);
+				delta_vel[1] += sign*(sbody->linear_vel[1] + cross_vec[1]);
+				delta_vel[2] += sign*(sbody->linear_vel[2] + cross_vec[2]);
+			}
+			sign = -1.0f;
+		}
+		b[i] = vDotProduct(delta_vel, rows[i].normal) - rows[i].bias;
+		for(j = 0; j < num_rows; j++)
+		{
+			b[i] -= a[(i*4)+j]*rows[j].impulse;
+		}
+		if(fabsf(b[i]) > max_b)
+			max_b = fabsf(b[i]);
+	}
+
+	//largest sets first, the empty set last
+	for(set = (1 << num_rows)-1; set >= 0; set--)
+	{
+		//A_ss*x_s = -b_s for the active contacts s
+		num_active = 0;
+		for(i = 0; i < num_rows; i++)
+		{
+			if(set & (1 << i))
+			{
+				index[num_active] = i;
+				num_active += 1;
+			}
+		}
+		for(i = 0; i < num_active; i++)
+		{
+			for(j = 0; j < num_active; j++)
+			{
+				a_set[(i*num_active)+j] = (double)a[(index[i]*4)+index[j]];
+			}
+			x_set[i] = -1.0*b[index[i]];
+		}
+		r = SolveLinearSystem(a_set, x_set, num_active, (SAT_BLOCK_PIVOT_EPSILON*max_k));
+		if(r == 0)
+			continue;
+
+		memset(x, 0, 4*sizeof(float));
+		for(i = 0; i < num_active; i++)
+		{
+			if(x_set[i] < 0.0)
+				break;
+			x[index[i]] = (float)x_set[i];
+		}
+		if(i < num_active)
+			continue;
+
+		//the inactive contacts must not approach
+		for(i = 0; i < num_rows; i++)
+		{
+			if(set & (1 << i))
+				continue;
+			vel = b[i];
+			for(j = 0; j < num_rows; j++)
+			{
+				vel += a[(i*4)+j]*x[j];
+			}
+			if(vel < -1.0f*SAT_BLOCK_VEL_EPSILON*max_b)
+				break;
+		}
+		if(i < num_rows)
+			continue;
+
+		for(j = 0; j < num_rows; j++)
+		{
+			impulse = x[j] - rows[j].impulse;
+			if(fabsf(impulse) > *residual)
+				*residual = fabsf(impulse);
+			rows[j].impulse = x[j];
+			ApplySolverImpulse(bodies, (rows+j), impulse);
+		}
+		return 1;
+	}
+
+	return 0;
+}
+
+/*
+Gaussian elimination with partial pivoting. 'a' is n*n row major and 'b' gets the
+solution. Both are overwritten.
+returns 0 if a pivot is smaller than 'pivot_epsilon'.
+*/
+static int SolveLinearSystem(double * a, double * b, int n, double pivot_epsilon)
+{
+	double factor;
+	double temp;
+	int i_pivot;
+	int i;
+	int j;
+	int k;
+
+	for(k = 0; k < n; k++)
+	{
+		i_pivot = k;
+		for(i = k+1; i < n; i++)
+		{
+			if(fabs(a[(i*n)+k]) > fabs(a[(i_pivot*n)+k]))
+				i_pivot = i;
+		}
+		if(fabs(a[(i_pivot*n)+k]) < pivot_epsilon)
+			return 0;
+		if(i_pivot != k)
+		{
+			for(j = k; j < n; j++)
+			{
+				temp = a[(k*n)+j];
+				a[(k*n)+j] = a[(i_pivot*n)+j];
+				a[(i_pivot*n)+j] = temp;
+			}
+			temp = b[k];
+			b[k] = b[i_pivot];
+			b[i_pivot] = temp;
+		}
+		for(i = k+1; i < n; i++)
+		{
+			factor = a[(i*n)+k]/a[(k*n)+k];
+			for(j = k; j < n; j++)
+			{
+				a[(i*n)+j] -= factor*a[(k*n)+j];
+			}
+			b[i] -= factor*b[k];
+		}
+	}
+	for(k = n-1; k >= 0; k--)
+	{
+		for(j = k+1; j < n; j++)
+		{
+			b[k] -= a[(k*n)+j]*b[j];
+		}
+		b[k] /= a[(k*n)+k];
+	}
+
+	return 1;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sat.h"
+
+static void * ThreadPoolWorker(void * arg);
+static void ThreadPoolDoTasks(struct thread_pool_struct * pool);
+
+//returns the # of online cpus, at least 1
+int GetNumCpus(void)
+{
+	long num_cpus;
+
+	num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if(num_cpus < 1)
+		return 1;
+	return (int)num_cpus;
+}
+
+/*
+Starts num_threads-1 worker threads. The thread that calls ThreadPoolRun() is the
+last worker, so num_threads=1 runs everything on the calling thread.
+*/
+int ThreadPoolInit(struct thread_pool_struct * pool, int num_threads)
+{
+	int i;
+	int r;
+
+	memset(pool, 0, sizeof(struct thread_pool_struct));
+	if(num_threads < 1)
+		num_threads = 1;
+
+	pthread_mutex_init(&(pool->lock), 0);
+	pthread_cond_init(&(pool->work_cond), 0);
+	pthread_cond_init(&(pool->done_cond), 0);
+	atomic_init(&(pool->next_task), 0);
+
+	pool->num_threads = num_threads;
+	if(num_threads == 1)
+		return 1;
+
+	pool->workers = (pthread_t*)malloc((num_threads-1)*sizeof(pthread_t));
+	if(pool->workers == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		pool->num_threads = 1;
+		return 0;
+	}
+	for(i = 0; i < (num_threads-1); i++)
+	{
+		r = pthread_create((pool->workers+i), 0, ThreadPoolWorker, pool);
+		if(r != 0)
+		{
+			printf("%s: error line %d\n", __func__, __LINE__);
+			pool->num_workers = i;
+			ThreadPoolFree(pool);
+			return 0;
+		}
+		pool->num_workers += 1;
+	}
+
+	return 1;
+}
+
+void ThreadPoolFree(struct thread_pool_struct * pool)
+{
+	int i;
+
+	pthread_mutex_lock(&(pool->lock));
+	pool->shutdown = 1;
+	pthread_cond_broadcast(&(pool->work_cond));
+	pthread_mutex_unlock(&(pool->lock));
+	for(i = 0; i < pool->num_workers; i++)
+	{
+		pthread_join(pool->workers[i], 0);
+	}
+	free(pool->workers);
+	pool->workers = 0;
+	pool->num_workers = 0;
+	pool->num_threads = 1;
+
+	pthread_mutex_destroy(&(pool->lock));
+	pthread_cond_destroy(&(pool->work_cond));
+	pthread_cond_destroy(&(pool->done_cond));
+}
+
+/*
+Calls job(user, i_task) for i_task = 0..num_tasks-1 spread over all threads of the
+pool and returns when every task is finished. Tasks must not depend on each other.
+*/
+void ThreadPoolRun(struct thread_pool_struct * pool, void (*job)(void * user, int i_task), void * user, int num_tasks)
+{
+	int i;
+
+	if(pool == 0 || pool->num_workers == 0 || num_tasks <= 1)
+	{
+		for(i = 0; i < num_tasks; i++)
+		{
+			job(user, i);
+		}
+		return;
+	}
+
+	pthread_mutex_lock(&(pool->lock));
+	pool->job = job;
+	pool->job_user = user;
+	pool->num_tasks = num_tasks;
+	atomic_store(&(pool->next_task), 0);
+	pool->num_workers_done = 0;
+	pool->generation += 1;
+	pthread_cond_broadcast(&(pool->work_cond));
+	pthread_mutex_unlock(&(pool->lock));
+
+	ThreadPoolDoTasks(pool);
+
+	pthread_mutex_lock(&(pool->lock));
+	while(pool->num_workers_done < pool->num_workers)
+	{
+		pthread_cond_wait(&(pool->done_cond), &(pool->lock));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+}
+
+//splits num_items into num_tasks ranges of about equal size, task i_task gets start .. end-1
+void GetTaskRange(int num_items, int num_tasks, int i_task, int * start, int * end)
+{
+	*start = (int)(((long long)num_items*i_task)/num_tasks);
+	*end = (int)(((long long)num_items*(i_task+1))/num_tasks);
+}
+
+static void * ThreadPoolWorker(void * arg)
+{
+	struct thread_pool_struct * pool;
+	int seen_generation=0;
+
+	pool = (struct thread_pool_struct*)arg;
+
+	pthread_mutex_lock(&(pool->lock));
+	for(;;)
+	{
+		while(pool->generation == seen_generation && pool->shutdown == 0)
+		{
+			pthread_cond_wait(&(pool->work_cond), &(pool->lock));
+		}
+		if(pool->shutdown == 1)
+			break;
+		seen_generation = pool->generation;
+		pthread_mutex_unlock(&(pool->lock));
+
+		ThreadPoolDoTasks(pool);
+
+		pthread_mutex_lock(&(pool->lock));
+		pool->num_workers_done += 1;
+		if(pool->num_workers_done == pool->num_workers)
+			pthread_cond_signal(&(pool->done_cond));
+	}
+	pthread_mutex_unlock(&(pool->lock));
+
+	return 0;
+}
+
+//grab tasks until there are none left
+static void ThreadPoolDoTasks(struct thread_pool_struct * pool)
+{
+	int i_task;
+
+	for(;;)
+	{
+		i_task = atomic_fetch_add(&(pool->next_task), 1);
+		if(i_task >= pool->num_tasks)
+			break;
+		pool->job(pool->job_user, i_task);
+	}
+}
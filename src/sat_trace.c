@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "sat_trace.h"
+
+/*
+The ring is a bounded multi-producer/single-consumer queue. Every slot has a
+sequence number:
+	seq == pos		slot is free for the producer that claimed pos
+	seq == pos+1	slot holds a message for the consumer
+Producers claim a position by advancing g_trace_head with a CAS, so no locks
+are taken by the simulation thread(s).
+
+g_trace_writers counts the producers between their g_trace_is_open check and
+their last touch of the ring. SatTraceClose() clears g_trace_is_open first and
+then waits for the count to reach zero before it frees the ring.
+*/
+struct trace_record_struct
+{
+	atomic_uint seq;
+	int level;
+	char msg[SAT_TRACE_MSG_LEN];
+};
+
+static struct trace_record_struct * g_trace_ring;
+static atomic_uint g_trace_head;	//next position to write, shared by producers
+static unsigned int g_trace_tail;	//next position to read, only used by the drain thread
+static atomic_uint g_trace_dropped;
+static atomic_int g_trace_is_open;
+static atomic_int g_trace_writers;	//producers that may still write into the ring
+static atomic_int g_trace_stop;
+static pthread_t g_trace_thread;
+static FILE * g_trace_file;
+
+static const char * g_trace_level_names[] = {"none", "error", "warn", "info", "debug", "verbose"};
+
+static void * TraceDrainThread(void * arg);
+static int TraceDrainRing(void);
+
+int SatTraceOpen(char * filename)
+{
+	unsigned int i;
+	int r;
+
+	if(atomic_load(&g_trace_is_open) == 1)
+		return 1;
+
+	g_trace_file = fopen(filename, "w");
+	if(g_trace_file == 0)
+	{
+		printf("%s: error. could not open %s\n", __func__, filename);
+		return 0;
+	}
+
+	g_trace_ring = (struct trace_record_struct*)malloc(SAT_TRACE_RING_SIZE*sizeof(struct trace_record_struct));
+	if(g_trace_ring == 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		fclose(g_trace_file);
+		return 0;
+	}
+	for(i = 0; i < SAT_TRACE_RING_SIZE; i++)
+	{
+		atomic_init(&(g_trace_ring[i].seq), i);
+	}
+	atomic_store(&g_trace_head, 0);
+	g_trace_tail = 0;
+	atomic_store(&g_trace_dropped, 0);
+	atomic_store(&g_trace_stop, 0);
+
+	r = pthread_create(&g_trace_thread, 0, TraceDrainThread, 0);
+	if(r != 0)
+	{
+		printf("%s: error line %d\n", __func__, __LINE__);
+		free(g_trace_ring);
+		g_trace_ring = 0;
+		fclose(g_trace_file);
+		return 0;
+	}
+	atomic_store(&g_trace_is_open, 1);
+
+	return 1;
+}
+
+//Stops the drain thread after it has written everything left in the ring.
+void SatTraceClose(void)
+{
+	const struct timespec writer_wait = {0, 100000}; //0.1ms
+	unsigned int dropped;
+
+	if(atomic_load(&g_trace_is_open) == 0)
+		return;
+
+	//new producers print to stdout from here on. wait for the ones already past the check
+	atomic_store(&g_trace_is_open, 0);
+	while(atomic_load(&g_trace_writers) != 0)
+	{
+		nanosleep(&writer_wait, 0);
+	}
+	atomic_store(&g_trace_stop, 1);
+	pthread_join(g_trace_thread, 0);
+
+	dropped = atomic_load(&g_trace_dropped);
+	if(dropped != 0)
+		fprintf(g_trace_file, "[warn] trace: %u messages dropped, ring was full\n", dropped);
+	fclose(g_trace_file);
+	g_trace_file = 0;
+	free(g_trace_ring);
+	g_trace_ring = 0;
+}
+
+void SatTraceWrite(int level, const char * fmt, ...)
+{
+	struct trace_record_struct * rec;
+	va_list args;
+	unsigned int pos;
+	unsigned int seq;
+	int diff;
+
+	va_start(args, fmt);
+
+	//count this producer before the check so SatTraceClose() can't free the ring under it.
+	//both sides are seq_cst, either Close sees the count or this sees the ring closed
+	atomic_fetch_add(&g_trace_writers, 1);
+
+	//nobody is draining the ring, just print it.
+	if(atomic_load(&g_trace_is_open) == 0)
+	{
+		atomic_fetch_sub(&g_trace_writers, 1);
+		printf("[%s] ", g_trace_level_names[level]);
+		vprintf(fmt, args);
+		printf("\n");
+		va_end(args);
+		return;
+	}
+
+	//claim a slot
+	pos = atomic_load_explicit(&g_trace_head, memory_order_relaxed);
+	for(;;)
+	{
+		rec = g_trace_ring + (pos & (SAT_TRACE_RING_SIZE-1));
+		seq = atomic_load_explicit(&(rec->seq), memory_order_acquire);
+		diff = (int)(seq - pos);
+		if(diff == 0)
+		{
+			if(atomic_compare_exchange_weak_explicit(&g_trace_head, &pos, pos+1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if(diff < 0) //ring is full. drop the message rather than wait.
+		{
+			atomic_fetch_add_explicit(&g_trace_dropped, 1, memory_order_relaxed);
+			atomic_fetch_sub(&g_trace_writers, 1);
+			va_end(args);
+			return;
+		}
+		else
+		{
+			pos = atomic_load_explicit(&g_trace_head, memory_order_relaxed);
+		}
+	}
+
+	rec->level = level;
+	vsnprintf(rec->msg, SAT_TRACE_MSG_LEN, fmt, args);
+	va_end(args);
+
+	//publish the slot to the drain thread
+	atomic_store_explicit(&(rec->seq), pos+1, memory_order_release);
+	atomic_fetch_sub(&g_trace_writers, 1);
+}
+
+unsigned int SatTraceGetDropped(void)
+{
+	return atomic_load(&g_trace_dropped);
+}
+
+static void * TraceDrainThread(void * arg)
+{
+	const struct timespec idle_wait = {0, 1000000}; //1ms
+
+	for(;;)
+	{
+		if(TraceDrainRing() == 0)
+		{
+			if(atomic_load(&g_trace_stop) == 1)
+				break;
+			fflush(g_trace_file);
+			nanosleep(&idle_wait, 0);
+		}
+	}
+	//catch anything written while stopping
+	TraceDrainRing();
+	fflush(g_trace_file);
+
+	return 0;
+}
+
+//returns the # of messages written to the trace file
+static int TraceDrainRing(void)
+{
+	struct trace_record_struct * rec;
+	unsigned int seq;
+	int num_written=0;
+
+	for(;;)
+	{
+		rec = g_trace_ring + (g_trace_tail & (SAT_TRACE_RING_SIZE-1));
+		seq = atomic_load_explicit(&(rec->seq), memory_order_acquire);
+		if((int)(seq - (g_trace_tail+1)) != 0)
+			break; //slot hasn't been published yet
+
+		fprintf(g_trace_file, "[%s] %s\n", g_trace_level_names[rec->level], rec->msg);
+
+		//give the slot back to producers for the next lap around the ring
+		atomic_store_explicit(&(rec->seq), g_trace_tail+SAT_TRACE_RING_SIZE, memory_order_release);
+		g_trace_tail += 1;
+		num_written += 1;
+	}
+
+	return num_written;
+}
@@ -0,0 +1,65 @@
+#ifndef SAT_TRACE_H
+#define SAT_TRACE_H
+
+/*
+Leveled trace facility for libsat.
+-the level is picked at compile time with -DSAT_TRACE_LEVEL=n. Trace calls above
+ that level are removed by the preprocessor, so a release build (level 0) has no
+ trace code in the collision/solver loops at all.
+-at runtime messages are formatted into a lock-free ring buffer and a background
+ thread writes them to the file given to SatTraceOpen(). If the ring is full the
+ message is dropped and counted instead of blocking the simulation.
+-if SatTraceOpen() was not called messages are printed to stdout directly.
+-SatTraceClose() can be called while other threads are still tracing. It waits
+ for the writes already going into the ring, later ones are printed to stdout.
+*/
+#define SAT_TRACE_NONE		0
+#define SAT_TRACE_ERROR		1
+#define SAT_TRACE_WARN		2
+#define SAT_TRACE_INFO		3
+#define SAT_TRACE_DEBUG		4
+#define SAT_TRACE_VERBOSE	5	//per-contact, per-iteration output
+
+#ifndef SAT_TRACE_LEVEL
+#define SAT_TRACE_LEVEL SAT_TRACE_WARN
+#endif
+
+#define SAT_TRACE_MSG_LEN	128	//max length of a message, longer messages are truncated
+#define SAT_TRACE_RING_SIZE	4096	//# of messages in the ring. must be a power of 2.
+
+#if SAT_TRACE_LEVEL >= SAT_TRACE_ERROR
+#define SAT_ERROR(...) SatTraceWrite(SAT_TRACE_ERROR, __VA_ARGS__)
+#else
+#define SAT_ERROR(...) ((void)0)
+#endif
+
+#if SAT_TRACE_LEVEL >= SAT_TRACE_WARN
+#define SAT_WARN(...) SatTraceWrite(SAT_TRACE_WARN, __VA_ARGS__)
+#else
+#define SAT_WARN(...) ((void)0)
+#endif
+
+#if SAT_TRACE_LEVEL >= SAT_TRACE_INFO
+#define SAT_INFO(...) SatTraceWrite(SAT_TRACE_INFO, __VA_ARGS__)
+#else
+#define SAT_INFO(...) ((void)0)
+#endif
+
+#if SAT_TRACE_LEVEL >= SAT_TRACE_DEBUG
+#define SAT_DEBUG(...) SatTraceWrite(SAT_TRACE_DEBUG, __VA_ARGS__)
+#else
+#define SAT_DEBUG(...) ((void)0)
+#endif
+
+#if SAT_TRACE_LEVEL >= SAT_TRACE_VERBOSE
+#define SAT_VERBOSE(...) SatTraceWrite(SAT_TRACE_VERBOSE, __VA_ARGS__)
+#else
+#define SAT_VERBOSE(...) ((void)0)
+#endif
+
+int SatTraceOpen(char * filename);
+void SatTraceClose(void);
+void SatTraceWrite(int level, const char * fmt, ...) __attribute__((format(printf, 2, 3)));
+unsigned int SatTraceGetDropped(void);
+
+#endif